@@ -39,5 +39,5 @@ std::generator<int64_t> prime_generator(std::size_t count) {
 }
 
 postgres_function(demo_srf, ([](int64_t t) {
-                    return prime_generator(t);
+                    return cppgres::value_per_call(prime_generator(t));
                   }));
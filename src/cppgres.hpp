@@ -44,6 +44,7 @@
 #include <fmt/core.h>
 namespace cppgres::fmt {
 using ::fmt::format;
+using ::fmt::format_to;
 }
 #else
 #error "Neither functional <format> nor <fmt/core.h> available"
@@ -51,6 +52,7 @@ using ::fmt::format;
 #else
 namespace cppgres::fmt {
 using std::format;
+using std::format_to;
 }
 #endif
 #elif __has_include(<fmt/core.h>)
@@ -58,31 +60,40 @@ using std::format;
 #include <fmt/core.h>
 namespace cppgres::fmt {
 using ::fmt::format;
+using ::fmt::format_to;
 }
 #else
 #error "Neither functional <format> nor <fmt/core.h> available"
 #endif
 
 #include "cppgres/aggregate.hpp"
+#include "cppgres/array.hpp"
 #include "cppgres/bgw.hpp"
 #include "cppgres/collation.hpp"
+#include "cppgres/datetime.hpp"
 #include "cppgres/datum.hpp"
 #include "cppgres/error.hpp"
 #include "cppgres/exception_impl.hpp"
 #include "cppgres/executor.hpp"
+#include "cppgres/expression.hpp"
 #include "cppgres/function.hpp"
 #include "cppgres/guard.hpp"
 #include "cppgres/guc.hpp"
 #include "cppgres/imports.h"
+#include "cppgres/inet.hpp"
+#include "cppgres/jsonb.hpp"
 #include "cppgres/list.hpp"
 #include "cppgres/memory.hpp"
 #include "cppgres/node.hpp"
+#include "cppgres/numeric.hpp"
+#include "cppgres/range.hpp"
 #include "cppgres/record.hpp"
 #include "cppgres/resource_owner.hpp"
 #include "cppgres/role.hpp"
 #include "cppgres/set.hpp"
 #include "cppgres/threading.hpp"
 #include "cppgres/types.hpp"
+#include "cppgres/uuid.hpp"
 #include "cppgres/value.hpp"
 #include "cppgres/xact.hpp"
 
@@ -0,0 +1,567 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datum.hpp"
+#include "function.hpp"
+#include "guard.hpp"
+#include "imports.h"
+#include "type.hpp"
+#include "types.hpp"
+#include "utils/utils.hpp"
+
+extern "C" {
+#include <utils/array.h>
+}
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace cppgres {
+
+/**
+ * @brief Fixed-width element types whose in-array representation is the C++ representation
+ */
+template <typename T> struct array_element_traits {};
+
+template <> struct array_element_traits<bool> {
+  static constexpr ::Oid element = BOOLOID;
+  static constexpr ::Oid array = BOOLARRAYOID;
+};
+
+template <> struct array_element_traits<int16_t> {
+  static constexpr ::Oid element = INT2OID;
+  static constexpr ::Oid array = INT2ARRAYOID;
+};
+
+template <> struct array_element_traits<int32_t> {
+  static constexpr ::Oid element = INT4OID;
+  static constexpr ::Oid array = INT4ARRAYOID;
+};
+
+template <> struct array_element_traits<int64_t> {
+  static constexpr ::Oid element = INT8OID;
+  static constexpr ::Oid array = INT8ARRAYOID;
+};
+
+template <> struct array_element_traits<float> {
+  static constexpr ::Oid element = FLOAT4OID;
+  static constexpr ::Oid array = FLOAT4ARRAYOID;
+};
+
+template <> struct array_element_traits<double> {
+  static constexpr ::Oid element = FLOAT8OID;
+  static constexpr ::Oid array = FLOAT8ARRAYOID;
+};
+
+template <typename T>
+concept fixed_width_array_element = requires {
+  { array_element_traits<T>::element } -> std::convertible_to<::Oid>;
+  { array_element_traits<T>::array } -> std::convertible_to<::Oid>;
+};
+
+/**
+ * @brief Postgres array (`ArrayType`)
+ *
+ * Arrays are detoasted on first access. Arrays of @ref cppgres::fixed_width_array_element types
+ * without nulls are accessed directly, without converting their elements; other arrays are
+ * deconstructed once, on first access to an element.
+ *
+ * Elements of multidimensional arrays are accessed in row-major order with `operator[]`, or by
+ * their subscripts with `at()`.
+ *
+ * @tparam T element type
+ */
+template <typename T> struct array : public varlena {
+  using varlena::varlena;
+  using element_type = T;
+
+  struct iterator {
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::optional<T>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() noexcept : a(nullptr), i(0) {}
+    iterator(array *a, std::size_t i) noexcept : a(a), i(i) {}
+
+    std::optional<T> operator*() const { return (*a)[i]; }
+    iterator &operator++() {
+      i++;
+      return *this;
+    }
+    iterator operator++(int) {
+      auto it = *this;
+      i++;
+      return it;
+    }
+
+    bool operator==(const iterator &other) const { return i == other.i; }
+
+  private:
+    array *a;
+    std::size_t i;
+  };
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size()); }
+
+  /**
+   * @brief Number of dimensions
+   */
+  int ndim() { return ARR_NDIM(get()); }
+
+  /**
+   * @brief Size of every dimension
+   */
+  std::span<const int> dims() {
+    auto *a = get();
+    return {ARR_DIMS(a), static_cast<std::size_t>(ARR_NDIM(a))};
+  }
+
+  /**
+   * @brief Lower bound of every dimension
+   */
+  std::span<const int> lower_bounds() {
+    auto *a = get();
+    return {ARR_LBOUND(a), static_cast<std::size_t>(ARR_NDIM(a))};
+  }
+
+  /**
+   * @brief Total number of elements
+   */
+  std::size_t size() {
+    auto *a = get();
+    return ffi_guard{::ArrayGetNItems}(ARR_NDIM(a), ARR_DIMS(a));
+  }
+
+  bool empty() { return size() == 0; }
+
+  bool has_nulls() { return ARR_HASNULL(get()); }
+
+  /**
+   * @brief Elements of the array, without copying or converting them
+   *
+   * @throws std::runtime_error if the array contains nulls
+   */
+  std::span<const T> values() requires fixed_width_array_element<T>
+  {
+    auto *a = get();
+    if (ARR_HASNULL(a)) {
+      throw std::runtime_error("array contains nulls");
+    }
+    return {reinterpret_cast<const T *>(ARR_DATA_PTR(a)),
+            static_cast<std::size_t>(ffi_guard{::ArrayGetNItems}(ARR_NDIM(a), ARR_DIMS(a)))};
+  }
+
+  /**
+   * @brief Element at position `i` (in row-major order), `std::nullopt` if it is null
+   *
+   * @throws std::out_of_range if `i` is outside of the array
+   */
+  std::optional<T> operator[](std::size_t i) {
+    if constexpr (fixed_width_array_element<T>) {
+      if (!has_nulls()) {
+        auto v = values();
+        if (i >= v.size()) {
+          throw std::out_of_range("array index out of range");
+        }
+        return v[i];
+      }
+    }
+    auto &e = elements();
+    if (i >= e.size()) {
+      throw std::out_of_range("array index out of range");
+    }
+    return from_nullable_datum<std::optional<T>>(nullable_datum(e[i]), ARR_ELEMTYPE(get()));
+  }
+
+  /**
+   * @brief Element at the given subscripts (one per dimension, from their lower bounds)
+   *
+   * @throws std::out_of_range if the subscripts are outside of the array's bounds
+   */
+  std::optional<T> at(std::initializer_list<int> subscripts) {
+    auto d = dims();
+    auto lb = lower_bounds();
+    if (subscripts.size() != d.size()) {
+      throw std::out_of_range(cppgres::fmt::format("expected {} subscripts, got {}", d.size(),
+                                                   subscripts.size()));
+    }
+    std::size_t offset = 0;
+    std::size_t n = 0;
+    for (auto subscript : subscripts) {
+      auto index = subscript - lb[n];
+      if (index < 0 || index >= d[n]) {
+        throw std::out_of_range("array subscript out of range");
+      }
+      offset = offset * d[n] + index;
+      n++;
+    }
+    return (*this)[offset];
+  }
+
+private:
+  ::ArrayType *get() {
+    auto *a = reinterpret_cast<::ArrayType *>(detoasted_ptr());
+    if (!checked) {
+      if (!type_traits<T>().is(type{.oid = ARR_ELEMTYPE(a)})) {
+        throw std::runtime_error(cppgres::fmt::format("expected array of {}, got array of {}",
+                                                      utils::type_name<T>(),
+                                                      type{.oid = ARR_ELEMTYPE(a)}.name()));
+      }
+      checked = true;
+    }
+    return a;
+  }
+
+  // Deconstructed once; shared by copies (element datums point into the array)
+  std::vector<::NullableDatum> &elements() {
+    if (deconstructed == nullptr) {
+      auto *a = get();
+      int16 typlen;
+      bool typbyval;
+      char typalign;
+      ffi_guard{::get_typlenbyvalalign}(ARR_ELEMTYPE(a), &typlen, &typbyval, &typalign);
+      ::Datum *values;
+      bool *nulls;
+      int n;
+      ffi_guard{::deconstruct_array}(a, ARR_ELEMTYPE(a), typlen, typbyval, typalign, &values,
+                                     &nulls, &n);
+      auto e = std::make_shared<std::vector<::NullableDatum>>(n);
+      for (int i = 0; i < n; i++) {
+        (*e)[i] = {.value = values[i], .isnull = nulls[i]};
+      }
+      ffi_guard{::pfree}(values);
+      ffi_guard{::pfree}(nulls);
+      deconstructed = std::move(e);
+    }
+    return *deconstructed;
+  }
+
+  bool checked = false;
+  std::shared_ptr<std::vector<::NullableDatum>> deconstructed;
+};
+
+/**
+ * @brief Builds an array out of contiguous values with a single allocation
+ *
+ * @param values elements, in row-major order
+ * @param dims size of every dimension; a single dimension of all values by default
+ * @param ctx memory context to allocate the array in
+ *
+ * @throws std::invalid_argument if a dimension is negative or the dimensions don't describe
+ *         `values`
+ * @throws std::length_error if the array is too large
+ */
+template <fixed_width_array_element T>
+array<T> make_array(std::span<const T> values, std::span<const int> dims = {},
+                    memory_context ctx = memory_context()) {
+  if (values.size() > MaxArraySize) {
+    throw std::length_error("array is too large");
+  }
+  int one_dim[1] = {static_cast<int>(values.size())};
+  if (dims.empty()) {
+    dims = values.empty() ? std::span<const int>() : std::span<const int>(one_dim);
+  }
+  if (dims.size() > MAXDIM) {
+    throw std::invalid_argument(
+        cppgres::fmt::format("number of array dimensions exceeds the maximum of {}", MAXDIM));
+  }
+  std::size_t n = dims.empty() ? 0 : 1;
+  for (auto d : dims) {
+    if (d < 0) {
+      throw std::invalid_argument(cppgres::fmt::format("invalid array dimension {}", d));
+    }
+    if (__builtin_mul_overflow(n, static_cast<std::size_t>(d), &n) || n > MaxArraySize) {
+      throw std::length_error("array is too large");
+    }
+  }
+  if (n != values.size()) {
+    throw std::invalid_argument(cppgres::fmt::format(
+        "array dimensions describe {} elements, got {}", n, values.size()));
+  }
+  auto ndim = static_cast<int>(dims.size());
+  auto overhead = ARR_OVERHEAD_NONULLS(ndim);
+  auto nbytes = overhead + values.size_bytes();
+  if (nbytes > MaxAllocSize) {
+    throw std::length_error("array is too large");
+  }
+  auto *a = reinterpret_cast<::ArrayType *>(ctx.alloc<std::byte>(nbytes));
+  std::memset(a, 0, overhead);
+  SET_VARSIZE(a, nbytes);
+  a->ndim = ndim;
+  a->dataoffset = 0;
+  a->elemtype = array_element_traits<T>::element;
+  for (int i = 0; i < ndim; i++) {
+    ARR_DIMS(a)[i] = dims[i];
+    ARR_LBOUND(a)[i] = 1;
+  }
+  std::memcpy(ARR_DATA_PTR(a), values.data(), values.size_bytes());
+  return array<T>(datum(PointerGetDatum(a)), ctx);
+}
+
+template <typename T> struct type_traits<array<T>> {
+  type_traits() {}
+  type_traits(const array<T> &) {}
+  bool is(const type &t) {
+    if constexpr (fixed_width_array_element<T>) {
+      return t.oid == array_element_traits<T>::array;
+    } else {
+      auto element = ffi_guard{::get_element_type}(t.oid);
+      return OidIsValid(element) && type_traits<T>().is(type{.oid = element});
+    }
+  }
+  type type_for() {
+    if constexpr (fixed_width_array_element<T>) {
+      return type{.oid = array_element_traits<T>::array};
+    } else {
+      return type{.oid = ffi_guard{::get_array_type}(type_traits<T>().type_for().oid)};
+    }
+  }
+};
+
+template <typename T> struct datum_conversion<array<T>> : default_datum_conversion<array<T>> {
+  static array<T> from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return array<T>{d, ctx};
+  }
+
+  static datum into_datum(const array<T> &t) { return t.get_datum(); }
+};
+
+/**
+ * @brief Mutable array in Postgres' expanded representation (`ExpandedArrayHeader`)
+ *
+ * Elements are kept deconstructed in the expanded object's own memory context and are updated
+ * in place; appending grows the element storage geometrically, so it takes amortized constant
+ * time. The array is only flattened when it is stored or passed to a function that needs the
+ * flat representation.
+ *
+ * Converting from a read/write expanded array datum (such as the state passed to an aggregate's
+ * transition function by a previous transition) takes it over without copying it. Any other
+ * array is expanded into the aggregate memory context when called from an aggregate, and into
+ * the current memory context otherwise. Converting into a datum hands out a read/write expanded
+ * datum; as the expanded object belongs to the aggregate memory context, the executor keeps it
+ * as the new state as is, so aggregate states are neither copied nor flattened between
+ * transitions.
+ *
+ * Copies refer to the same expanded object.
+ *
+ * @tparam T element type
+ */
+template <typename T> struct expanded_array {
+  using element_type = T;
+
+  /**
+   * @brief Creates an empty array in the aggregate memory context when called from an aggregate,
+   * or in the current memory context otherwise
+   */
+  expanded_array() : expanded_array(memory_context(default_context())) {}
+
+  /**
+   * @brief Creates an empty array
+   *
+   * @param ctx parent of the memory context the array is kept in
+   */
+  explicit expanded_array(memory_context ctx)
+      : eah(ffi_guard{::construct_empty_expanded_array}(type_traits<T>().type_for().oid, ctx,
+                                                         nullptr)) {}
+
+  /**
+   * @brief Takes over a read/write expanded array datum, or expands any other array datum
+   */
+  explicit expanded_array(const datum &d) : eah(expand(d)) {
+    if (!type_traits<T>().is(type{.oid = eah->element_type})) {
+      throw std::runtime_error(cppgres::fmt::format("expected array of {}, got array of {}",
+                                                    utils::type_name<T>(),
+                                                    type{.oid = eah->element_type}.name()));
+    }
+  }
+
+  /**
+   * @brief Number of dimensions
+   */
+  int ndim() const { return eah->ndims; }
+
+  /**
+   * @brief Total number of elements
+   */
+  std::size_t size() const { return ffi_guard{::ArrayGetNItems}(eah->ndims, eah->dims); }
+
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Number of elements that can be held without growing the element storage
+   */
+  std::size_t capacity() {
+    deconstruct();
+    return eah->dvalueslen;
+  }
+
+  /**
+   * @brief Grows the element storage to hold at least `n` elements
+   */
+  void reserve(std::size_t n) {
+    deconstruct();
+    if (n <= static_cast<std::size_t>(eah->dvalueslen)) {
+      return;
+    }
+    if (n > MaxArraySize) {
+      throw std::length_error("array is too large");
+    }
+    eah->dvalues = static_cast<::Datum *>(ffi_guard{::repalloc}(eah->dvalues, n * sizeof(::Datum)));
+    if (eah->dnulls != nullptr) {
+      eah->dnulls = static_cast<bool *>(ffi_guard{::repalloc}(eah->dnulls, n * sizeof(bool)));
+    }
+    eah->dvalueslen = static_cast<int>(n);
+  }
+
+  /**
+   * @brief Element at position `i` (in row-major order), `std::nullopt` if it is null
+   *
+   * @note Values of pass-by-reference types point into the array and are only valid until the
+   *       element is replaced.
+   */
+  std::optional<T> operator[](std::size_t i) {
+    deconstruct();
+    if (i >= static_cast<std::size_t>(eah->nelems)) {
+      throw std::out_of_range("array index out of range");
+    }
+    if (eah->dnulls != nullptr && eah->dnulls[i]) {
+      return std::nullopt;
+    }
+    return from_nullable_datum<std::optional<T>>(nullable_datum(eah->dvalues[i]),
+                                                 eah->element_type);
+  }
+
+  /**
+   * @brief Replaces the element at position `i` (in row-major order) in place
+   */
+  void set(std::size_t i, const std::optional<T> &value) {
+    auto n = size();
+    if (i >= n) {
+      throw std::out_of_range("array index out of range");
+    }
+    int subscripts[MAXDIM];
+    for (int d = eah->ndims - 1; d >= 0; d--) {
+      subscripts[d] = eah->lbound[d] + static_cast<int>(i % eah->dims[d]);
+      i /= eah->dims[d];
+    }
+    assign(eah->ndims, subscripts, value);
+  }
+
+  /**
+   * @brief Appends an element to a one-dimensional (or empty) array in place
+   *
+   * @throws std::logic_error if the array is multidimensional
+   */
+  void push_back(const std::optional<T> &value) {
+    if (eah->ndims > 1) {
+      throw std::logic_error("can only append to one-dimensional arrays");
+    }
+    deconstruct();
+    if (eah->nelems == eah->dvalueslen) {
+      reserve(std::max<std::size_t>(8, static_cast<std::size_t>(eah->dvalueslen) * 2));
+    }
+    int subscript = eah->ndims == 0 ? 1 : eah->lbound[0] + eah->dims[0];
+    assign(1, &subscript, value);
+  }
+
+  /**
+   * @brief Read/write expanded datum
+   *
+   * Functions receiving it may modify the array in place.
+   */
+  datum get_datum() const { return datum(EOHPGetRWDatum(&eah->hdr)); }
+
+  /**
+   * @brief Read-only expanded datum
+   */
+  datum get_ro_datum() const { return datum(EOHPGetRODatum(&eah->hdr)); }
+
+private:
+  /**
+   * @brief Aggregate memory context if called from an aggregate, current memory context otherwise
+   */
+  static ::MemoryContext default_context() {
+    ::MemoryContext aggctx = nullptr;
+    if (auto info = current_postgres_function::call_info();
+        info.has_value() && ffi_guard{::AggCheckCallContext}(*info, &aggctx) != 0) {
+      return aggctx;
+    }
+    return ::CurrentMemoryContext;
+  }
+
+  static ::ExpandedArrayHeader *expand(const datum &d) {
+    auto raw = d.operator const ::Datum &();
+    if (VARATT_IS_EXTERNAL_EXPANDED_RW(DatumGetPointer(raw))) {
+      return ffi_guard{::DatumGetExpandedArray}(raw);
+    }
+    // Expanded as a child of the aggregate memory context, the array is kept as the aggregate's
+    // state by `ExecAggCopyTransValue` without being copied (and flattened)
+    return ffi_guard{::DatumGetExpandedArray}(
+        ffi_guard{::expand_array}(raw, default_context(), nullptr));
+  }
+
+  void deconstruct() { ffi_guard{::deconstruct_expanded_array}(eah); }
+
+  void assign(int nsubscripts, int *subscripts, const std::optional<T> &value) {
+    nullable_datum nd = into_nullable_datum(value);
+    // The value is copied into the array's memory context and, as the array is a read/write
+    // expanded object, it is updated in place
+    ::Datum d = ffi_guard{::array_set_element}(
+        get_datum(), nsubscripts, subscripts,
+        nd.is_null() ? ::Datum(0) : static_cast<const ::Datum &>(static_cast<const datum &>(nd)),
+        nd.is_null(), -1, eah->typlen, eah->typbyval, eah->typalign);
+    eah = reinterpret_cast<::ExpandedArrayHeader *>(DatumGetEOHP(d));
+  }
+
+  ::ExpandedArrayHeader *eah;
+};
+
+template <typename T> struct type_traits<expanded_array<T>> {
+  type_traits() {}
+  type_traits(const expanded_array<T> &) {}
+  bool is(const type &t) { return type_traits<array<T>>().is(t); }
+  type type_for() { return type_traits<array<T>>().type_for(); }
+};
+
+template <typename T>
+struct datum_conversion<expanded_array<T>> : default_datum_conversion<expanded_array<T>> {
+  static expanded_array<T> from_datum(const datum &d, oid, std::optional<memory_context>) {
+    return expanded_array<T>(d);
+  }
+
+  static datum into_datum(const expanded_array<T> &t) { return t.get_datum(); }
+};
+
+/**
+ * @brief Arrays of fixed-width values as contiguous spans
+ *
+ * Converting from an array doesn't copy it (unless it has to be detoasted) and fails if it
+ * contains nulls; converting into an array copies the span with a single allocation.
+ */
+template <fixed_width_array_element T> struct type_traits<std::span<const T>> {
+  type_traits() {}
+  type_traits(const std::span<const T> &) {}
+  bool is(const type &t) { return t.oid == array_element_traits<T>::array; }
+  constexpr type type_for() { return type{.oid = array_element_traits<T>::array}; }
+};
+
+template <fixed_width_array_element T>
+struct datum_conversion<std::span<const T>> : default_datum_conversion<std::span<const T>> {
+  static std::span<const T> from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return array<T>{d, ctx}.values();
+  }
+
+  static datum into_datum(const std::span<const T> &t) { return make_array(t).get_datum(); }
+};
+
+} // namespace cppgres
@@ -0,0 +1,264 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datum.hpp"
+#include "guard.hpp"
+#include "imports.h"
+#include "memory.hpp"
+#include "type.hpp"
+#include "types.hpp"
+
+extern "C" {
+#include <datatype/timestamp.h>
+#include <utils/date.h>
+#include <utils/timestamp.h>
+}
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+namespace cppgres {
+
+/**
+ * @brief Clock counting microseconds since Postgres' epoch (2000-01-01 00:00:00 UTC)
+ *
+ * Time points of this clock have the same representation as `timestamptz` values.
+ */
+struct postgres_clock {
+  using rep = int64_t;
+  using period = std::micro;
+  using duration = std::chrono::microseconds;
+  using time_point = std::chrono::time_point<postgres_clock>;
+  static constexpr bool is_steady = false;
+
+  /**
+   * @brief Offset of Postgres' epoch from the Unix epoch
+   */
+  static constexpr std::chrono::seconds epoch_offset{
+      static_cast<int64_t>(POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * SECS_PER_DAY};
+
+  static time_point now() { return time_point(duration(::GetCurrentTimestamp())); }
+
+  template <typename Duration>
+  static std::chrono::sys_time<std::common_type_t<Duration, std::chrono::seconds>>
+  to_sys(const std::chrono::time_point<postgres_clock, Duration> &t) {
+    return std::chrono::sys_time<std::common_type_t<Duration, std::chrono::seconds>>(
+        t.time_since_epoch() + epoch_offset);
+  }
+
+  template <typename Duration>
+  static std::chrono::time_point<postgres_clock, std::common_type_t<Duration, std::chrono::seconds>>
+  from_sys(const std::chrono::sys_time<Duration> &t) {
+    return std::chrono::time_point<postgres_clock,
+                                   std::common_type_t<Duration, std::chrono::seconds>>(
+        t.time_since_epoch() - epoch_offset);
+  }
+};
+
+/**
+ * @brief Pseudo-clock of local (time zone-less) time since 2000-01-01 00:00:00
+ *
+ * Time points of this clock have the same representation as `timestamp` (with microseconds) and
+ * `date` (with days) values. It can't tell the current time.
+ */
+struct postgres_local_clock {
+  using rep = int64_t;
+  using period = std::micro;
+  using duration = std::chrono::microseconds;
+  using time_point = std::chrono::time_point<postgres_local_clock>;
+  static constexpr bool is_steady = false;
+
+  template <typename Duration>
+  static std::chrono::local_time<std::common_type_t<Duration, std::chrono::seconds>>
+  to_local(const std::chrono::time_point<postgres_local_clock, Duration> &t) {
+    return std::chrono::local_time<std::common_type_t<Duration, std::chrono::seconds>>(
+        t.time_since_epoch() + postgres_clock::epoch_offset);
+  }
+
+  template <typename Duration>
+  static std::chrono::time_point<postgres_local_clock,
+                                 std::common_type_t<Duration, std::chrono::seconds>>
+  from_local(const std::chrono::local_time<Duration> &t) {
+    return std::chrono::time_point<postgres_local_clock,
+                                   std::common_type_t<Duration, std::chrono::seconds>>(
+        t.time_since_epoch() - postgres_clock::epoch_offset);
+  }
+};
+
+/**
+ * @brief `timestamp with time zone`
+ *
+ * `-infinity` and `infinity` are `timestamptz::min()` and `timestamptz::max()`.
+ */
+using timestamptz = std::chrono::time_point<postgres_clock, std::chrono::microseconds>;
+
+/**
+ * @brief `timestamp` (without time zone)
+ *
+ * `-infinity` and `infinity` are `timestamp::min()` and `timestamp::max()`.
+ */
+using timestamp = std::chrono::time_point<postgres_local_clock, std::chrono::microseconds>;
+
+/**
+ * @brief `date`
+ *
+ * `-infinity` and `infinity` are `date::min()` and `date::max()`. Dates and timestamps share
+ * their clock, so `std::chrono::floor<std::chrono::days>(ts)` is the date of timestamp `ts`.
+ */
+using date = std::chrono::time_point<postgres_local_clock, std::chrono::days>;
+
+/**
+ * @brief `interval`
+ *
+ * Months and days are kept apart from the time, as their duration varies.
+ */
+struct interval {
+  int32_t months = 0;
+  int32_t days = 0;
+  std::chrono::microseconds time{0};
+
+  bool operator==(const interval &) const = default;
+
+  /**
+   * @brief Duration of the interval, with the conventions Postgres uses to compare intervals
+   * (months of 30 days and days of 24 hours)
+   */
+  std::chrono::microseconds duration() const {
+    return time + std::chrono::microseconds(
+                      (static_cast<int64_t>(months) * DAYS_PER_MONTH + days) * USECS_PER_DAY);
+  }
+};
+
+template <> struct utils::single_value<interval> : std::true_type {};
+
+template <> struct type_traits<timestamptz> {
+  type_traits() {}
+  type_traits(const timestamptz &) {}
+  bool is(const type &t) { return t.oid == TIMESTAMPTZOID; }
+  constexpr type type_for() { return type{.oid = TIMESTAMPTZOID}; }
+};
+
+template <> struct type_traits<timestamp> {
+  type_traits() {}
+  type_traits(const timestamp &) {}
+  bool is(const type &t) { return t.oid == TIMESTAMPOID; }
+  constexpr type type_for() { return type{.oid = TIMESTAMPOID}; }
+};
+
+template <> struct type_traits<date> {
+  type_traits() {}
+  type_traits(const date &) {}
+  bool is(const type &t) { return t.oid == DATEOID; }
+  constexpr type type_for() { return type{.oid = DATEOID}; }
+};
+
+/**
+ * @brief `time` (without time zone), as the time since midnight
+ */
+template <> struct type_traits<std::chrono::microseconds> {
+  type_traits() {}
+  type_traits(const std::chrono::microseconds &) {}
+  bool is(const type &t) { return t.oid == TIMEOID; }
+  constexpr type type_for() { return type{.oid = TIMEOID}; }
+};
+
+template <> struct type_traits<interval> {
+  type_traits() {}
+  type_traits(const interval &) {}
+  bool is(const type &t) { return t.oid == INTERVALOID; }
+  constexpr type type_for() { return type{.oid = INTERVALOID}; }
+};
+
+template <> struct datum_conversion<timestamptz> : default_datum_conversion<timestamptz> {
+  static timestamptz from_datum(const datum &d, oid, std::optional<memory_context>) {
+    return timestamptz(
+        std::chrono::microseconds(DatumGetTimestampTz(d.operator const ::Datum &())));
+  }
+
+  static datum into_datum(const timestamptz &t) {
+    auto v = t.time_since_epoch().count();
+    if (!TIMESTAMP_NOT_FINITE(v) && !IS_VALID_TIMESTAMP(v)) {
+      throw std::out_of_range("timestamp out of range");
+    }
+    return datum(TimestampTzGetDatum(v));
+  }
+};
+
+template <> struct datum_conversion<timestamp> : default_datum_conversion<timestamp> {
+  static timestamp from_datum(const datum &d, oid, std::optional<memory_context>) {
+    return timestamp(std::chrono::microseconds(DatumGetTimestamp(d.operator const ::Datum &())));
+  }
+
+  static datum into_datum(const timestamp &t) {
+    auto v = t.time_since_epoch().count();
+    if (!TIMESTAMP_NOT_FINITE(v) && !IS_VALID_TIMESTAMP(v)) {
+      throw std::out_of_range("timestamp out of range");
+    }
+    return datum(TimestampGetDatum(v));
+  }
+};
+
+template <> struct datum_conversion<date> : default_datum_conversion<date> {
+  static date from_datum(const datum &d, oid, std::optional<memory_context>) {
+    auto v = DatumGetDateADT(d.operator const ::Datum &());
+    if (DATE_IS_NOBEGIN(v)) {
+      return date::min();
+    } else if (DATE_IS_NOEND(v)) {
+      return date::max();
+    }
+    return date(std::chrono::days(v));
+  }
+
+  static datum into_datum(const date &t) {
+    if (t == date::min()) {
+      return datum(DateADTGetDatum(DATEVAL_NOBEGIN));
+    } else if (t == date::max()) {
+      return datum(DateADTGetDatum(DATEVAL_NOEND));
+    }
+    auto v = t.time_since_epoch().count();
+    if (v < DATEVAL_NOBEGIN || v > DATEVAL_NOEND || !IS_VALID_DATE(static_cast<DateADT>(v))) {
+      throw std::out_of_range("date out of range");
+    }
+    return datum(DateADTGetDatum(static_cast<DateADT>(v)));
+  }
+};
+
+template <>
+struct datum_conversion<std::chrono::microseconds>
+    : default_datum_conversion<std::chrono::microseconds> {
+  static std::chrono::microseconds from_datum(const datum &d, oid, std::optional<memory_context>) {
+    return std::chrono::microseconds(DatumGetTimeADT(d.operator const ::Datum &()));
+  }
+
+  static datum into_datum(const std::chrono::microseconds &t) {
+    if (t.count() < 0 || t.count() > USECS_PER_DAY) {
+      throw std::out_of_range("time out of range");
+    }
+    return datum(TimeADTGetDatum(t.count()));
+  }
+};
+
+/**
+ * @brief Intervals are read in place; converting into an interval allocates it in the current
+ * memory context
+ */
+template <> struct datum_conversion<interval> : default_datum_conversion<interval> {
+  static interval from_datum(const datum &d, oid, std::optional<memory_context>) {
+    auto *i = DatumGetIntervalP(d.operator const ::Datum &());
+    return {.months = i->month, .days = i->day, .time = std::chrono::microseconds(i->time)};
+  }
+
+  static datum into_datum(const interval &t) {
+    auto *i = memory_context().alloc<::Interval>();
+    i->month = t.months;
+    i->day = t.days;
+    i->time = t.time.count();
+    return datum(IntervalPGetDatum(i));
+  }
+};
+
+} // namespace cppgres
@@ -10,9 +10,17 @@
 #include "types.hpp"
 #include "utils/cstring.hpp"
 
+#include <algorithm>
+#include <exception>
 #include <iterator>
+#include <list>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <stack>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace cppgres {
@@ -73,6 +81,206 @@ concept a_vector = requires {
   typename T::allocator_type;
 } && std::same_as<T, std::vector<typename T::value_type, typename T::allocator_type>>;
 
+/**
+ * @brief Callable or output iterator that rows of type `Ret` can be passed to
+ */
+template <typename F, typename Ret>
+concept result_sink =
+    std::invocable<std::remove_reference_t<F> &, Ret &> ||
+    std::output_iterator<std::remove_cvref_t<F>, const Ret &>;
+
+/**
+ * @brief Backend-local cache of prepared SPI statements
+ *
+ * Statements are prepared with `SPI_prepare_cursor`, kept with `SPI_keepplan` and looked up by
+ * their query text, argument types and plan choice. Kept plans are revalidated by the plan cache
+ * of Postgres whenever the relations (or other objects) they depend on change, so cached
+ * statements remain correct after DDL. Once the capacity is reached, the least recently used
+ * statements are evicted.
+ *
+ * @note Statements that are being executed are never evicted; the cache may temporarily exceed
+ *       its capacity because of that.
+ */
+struct spi_statement_cache {
+  /**
+   * @brief Planning choice for cached statements
+   */
+  enum class plan_choice : int {
+    /**
+     * @brief Let the plan cache choose between custom and generic plans
+     */
+    automatic = 0,
+    /**
+     * @brief Always use a generic plan
+     */
+    generic = CURSOR_OPT_GENERIC_PLAN,
+    /**
+     * @brief Always plan for the given arguments
+     */
+    custom = CURSOR_OPT_CUSTOM_PLAN
+  };
+
+private:
+  struct entry {
+    std::string query;
+    std::vector<::Oid> types;
+    int cursor_options;
+    ::SPIPlanPtr plan = nullptr;
+    int pins = 0;
+  };
+
+public:
+  explicit spi_statement_cache(std::size_t capacity = 128) : capacity_(capacity) {}
+
+  spi_statement_cache(const spi_statement_cache &) = delete;
+  spi_statement_cache &operator=(const spi_statement_cache &) = delete;
+
+  /**
+   * @brief Cached plan, pinned (not evictable) while the handle exists
+   */
+  struct handle {
+    handle(handle &&other) noexcept
+        : cache(std::exchange(other.cache, nullptr)), it(other.it) {}
+    handle(const handle &) = delete;
+    handle &operator=(const handle &) = delete;
+    handle &operator=(handle &&) = delete;
+    ~handle() {
+      if (cache != nullptr) {
+        cache->unpin(it);
+      }
+    }
+
+    operator ::SPIPlanPtr() const noexcept { return it->plan; }
+
+  private:
+    friend struct spi_statement_cache;
+    handle(spi_statement_cache &cache, std::list<entry>::iterator it) : cache(&cache), it(it) {
+      it->pins++;
+    }
+
+    spi_statement_cache *cache;
+    std::list<entry>::iterator it;
+  };
+
+  /**
+   * @brief Returns a cached plan, preparing and keeping it if it is not cached
+   *
+   * @throws std::runtime_error if the statement can't be prepared
+   */
+  handle prepare(std::string_view query, std::span<const ::Oid> types,
+                 plan_choice choice = plan_choice::automatic) {
+    key k{query, types, static_cast<int>(choice)};
+    if (auto found = index.find(k); found != index.end()) {
+      hits_++;
+      entries.splice(entries.begin(), entries, found->second);
+      return handle(*this, found->second);
+    }
+    misses_++;
+    entry e{.query = std::string(query),
+            .types = std::vector<::Oid>(types.begin(), types.end()),
+            .cursor_options = static_cast<int>(choice)};
+    auto plan = ffi_guard{::SPI_prepare_cursor}(e.query.c_str(), static_cast<int>(e.types.size()),
+                                                e.types.data(), e.cursor_options);
+    if (plan == nullptr) {
+      throw std::runtime_error(cppgres::fmt::format("can't prepare `{}`: {}", query,
+                                                    ::SPI_result_code_string(SPI_result)));
+    }
+    if (ffi_guard{::SPI_keepplan}(plan) != 0) {
+      ffi_guard{::SPI_freeplan}(plan);
+      throw std::runtime_error(cppgres::fmt::format("can't keep the plan of `{}`", query));
+    }
+    e.plan = plan;
+    entries.push_front(std::move(e));
+    auto it = entries.begin();
+    index.emplace(key{it->query, it->types, it->cursor_options}, it);
+    handle h(*this, it);
+    evict();
+    return h;
+  }
+
+  /**
+   * @brief Maximum number of cached statements
+   */
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  /**
+   * @brief Changes the capacity, evicting statements if necessary
+   */
+  void set_capacity(std::size_t capacity) {
+    capacity_ = capacity;
+    evict();
+  }
+
+  /**
+   * @brief Number of cached statements
+   */
+  std::size_t size() const noexcept { return entries.size(); }
+
+  /**
+   * @brief Number of lookups that found a cached statement
+   */
+  uint64_t hits() const noexcept { return hits_; }
+
+  /**
+   * @brief Number of lookups that had to prepare a statement
+   */
+  uint64_t misses() const noexcept { return misses_; }
+
+  /**
+   * @brief Evicts all statements that are not being executed
+   */
+  void clear() { evict(0); }
+
+private:
+  struct key {
+    std::string_view query;
+    std::span<const ::Oid> types;
+    int cursor_options;
+
+    bool operator==(const key &other) const {
+      return cursor_options == other.cursor_options && query == other.query &&
+             std::ranges::equal(types, other.types);
+    }
+  };
+
+  struct key_hash {
+    std::size_t operator()(const key &k) const noexcept {
+      auto h = std::hash<std::string_view>{}(k.query) ^ std::hash<int>{}(k.cursor_options);
+      for (auto oid : k.types) {
+        h = h * 31 + oid;
+      }
+      return h;
+    }
+  };
+
+  void unpin(std::list<entry>::iterator it) noexcept {
+    it->pins--;
+    ffi_guard_noexcept([this] { evict(); }, "failed to evict cached statements");
+  }
+
+  void evict() { evict(capacity_); }
+
+  void evict(std::size_t capacity) {
+    for (auto it = entries.end(); entries.size() > capacity && it != entries.begin();) {
+      --it;
+      if (it->pins > 0) {
+        continue;
+      }
+      index.erase(key{it->query, it->types, it->cursor_options});
+      auto plan = it->plan;
+      it = entries.erase(it);
+      ffi_guard{::SPI_freeplan}(plan);
+    }
+  }
+
+  std::size_t capacity_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  // most recently used first
+  std::list<entry> entries;
+  std::unordered_map<key, std::list<entry>::iterator, key_hash> index;
+};
+
 /**
  * @brief SPI connection options
  */
@@ -105,32 +313,156 @@ struct spi_executor : public executor {
     executors.pop();
   }
 
+  /**
+   * @brief Checks that results described by `tupdesc` can be decoded into `Ret`
+   *
+   * @throws std::runtime_error if the number of attributes doesn't match
+   * @throws std::invalid_argument if an attribute is of an incompatible type
+   */
+  template <typename Ret> static void check_result_types(::TupleDesc tupdesc) {
+    auto natts = tupdesc->natts;
+    if constexpr (a_vector<Ret>) {
+      for (int i = 0; i < natts; i++) {
+        auto oid = TupleDescAttr(tupdesc, i)->atttypid;
+        auto t = type{.oid = oid};
+        if (!type_traits<typename Ret::value_type>().is(t)) {
+          throw std::invalid_argument(
+              cppgres::fmt::format("invalid return type in position {} ({}), got OID {}", i,
+                                   utils::type_name<typename Ret::value_type>(), oid));
+        }
+      }
+    } else {
+      if (natts != utils::tuple_size_v<Ret>) {
+        if (natts == 1 && convertible_from_datum<Ret>) {
+          // okay, this is just a type we can convert
+        } else {
+          throw std::runtime_error(cppgres::fmt::format("expected {} return values, got {}",
+                                                        utils::tuple_size_v<Ret>, natts));
+        }
+      } else {
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+          (([&] {
+             auto oid = TupleDescAttr(tupdesc, Is)->atttypid;
+             auto t = type{.oid = oid};
+             if (!type_traits<utils::tuple_element_t<Is, Ret>>().is(t)) {
+               throw std::invalid_argument(cppgres::fmt::format(
+                   "invalid return type in position {} ({}), got OID {}", Is,
+                   utils::type_name<utils::tuple_element_t<Is, Ret>>(), oid));
+             }
+           }()),
+           ...);
+        }(std::make_index_sequence<utils::tuple_size_v<Ret>>{});
+      }
+    }
+  }
+
+  /**
+   * @brief True if rows of `T` are decoded from the first attribute alone
+   */
+  template <typename T> static bool single_attribute_row(std::size_t natts) {
+    if constexpr (convertible_from_datum<T>) {
+      return composite_type<T> || natts == 1;
+    } else {
+      return false;
+    }
+  }
+
+  /**
+   * @brief Decodes a row from its attributes
+   */
+  template <typename T>
+  static T decode_row(const ::Datum *values, const bool *isnull, std::span<const ::Oid> types,
+                      memory_context ctx) {
+    auto attribute = [&](std::size_t i) {
+      ::NullableDatum datum = {.value = values[i], .isnull = isnull[i]};
+      return nullable_datum(datum);
+    };
+    if constexpr (convertible_from_datum<T>) {
+      // if a special case of a directly convertible type
+      if (single_attribute_row<T>(types.size())) {
+        return from_nullable_datum<T>(attribute(0), types[0], ctx);
+      }
+    }
+    if constexpr (a_vector<T>) {
+      T ret;
+      ret.reserve(types.size());
+      for (std::size_t i = 0; i < types.size(); i++) {
+        ret.emplace_back(
+            from_nullable_datum<typename T::value_type>(attribute(i), types[i], ctx));
+      }
+      return ret;
+    } else {
+      return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+        return T{from_nullable_datum<utils::tuple_element_t<Is, T>>(attribute(Is), types[Is],
+                                                                     ctx)...};
+      }(std::make_index_sequence<utils::tuple_size_v<T>>{});
+    }
+  }
+
+  /**
+   * @brief Rows of a result, decoded on first access
+   *
+   * Shared by @ref cppgres::spi_executor::results and all of its iterators, so that every row is
+   * decoded at most once, no matter how many iterators are created or copied.
+   */
+  template <typename T> struct decoded_rows {
+    explicit decoded_rows(::SPITupleTable *tuptable)
+        : tuptable(tuptable), rows(tuptable->numvals), types(tuptable->tupdesc->natts),
+          values(tuptable->tupdesc->natts),
+          isnull(std::make_unique<bool[]>(tuptable->tupdesc->natts)) {
+      for (std::size_t i = 0; i < types.size(); i++) {
+        types[i] = TupleDescAttr(tuptable->tupdesc, i)->atttypid;
+      }
+    }
+
+    /**
+     * @brief Returns a row, decoding it if necessary
+     */
+    T &operator[](std::size_t n) {
+      auto &row = rows.at(n);
+      if (row.has_value()) {
+        return row.value();
+      }
+      auto ctx = memory_context(tuptable->tuptabcxt);
+      if constexpr (convertible_from_datum<T>) {
+        // only the first attribute is needed
+        if (single_attribute_row<T>(types.size())) {
+          bool null;
+          ::Datum value =
+              ffi_unguarded{::SPI_getbinval}(tuptable->vals[n], tuptable->tupdesc, 1, &null);
+          return row.emplace(decode_row<T>(&value, &null, types, ctx));
+        }
+      }
+      // decode all attributes in one pass
+      ffi_unguarded{::heap_deform_tuple}(tuptable->vals[n], tuptable->tupdesc, values.data(),
+                                         isnull.get());
+      return row.emplace(decode_row<T>(values.data(), isnull.get(), types, ctx));
+    }
+
+    ::SPITupleTable *tuptable;
+
+  private:
+    std::vector<std::optional<T>> rows;
+    std::vector<::Oid> types;
+    // reused for every row
+    std::vector<::Datum> values;
+    std::unique_ptr<bool[]> isnull;
+  };
+
   template <typename T> struct result_iterator {
     using iterator_category = std::random_access_iterator_tag;
     using value_type = T;
     using difference_type = std::ptrdiff_t;
 
-    ::SPITupleTable *tuptable;
-    size_t index;
-    mutable std::vector<std::optional<T>> tuples;
+    constexpr result_iterator() noexcept : index(0) {}
 
-    constexpr result_iterator() noexcept {}
-
-    constexpr result_iterator(::SPITupleTable *tuptable) noexcept
-        : tuptable(tuptable), index(0),
-          tuples(std::vector<std::optional<T>>(tuptable->numvals, std::nullopt)) {
-      tuples.reserve(tuptable->numvals);
-    }
-    constexpr result_iterator(::SPITupleTable *tuptable, size_t n) noexcept
-        : tuptable(tuptable), index(n),
-          tuples(std::vector<std::optional<T>>(tuptable->numvals, std::nullopt)) {
-      tuples.reserve(tuptable->numvals);
-    }
+    result_iterator(std::shared_ptr<decoded_rows<T>> rows, size_t n = 0) noexcept
+        : rows(std::move(rows)), index(n) {}
 
     bool operator==(size_t end_index) const { return index == end_index; }
     bool operator!=(size_t end_index) const { return index != end_index; }
 
-    constexpr T &operator*() const { return this->operator[](static_cast<difference_type>(index)); }
+    T &operator*() const { return (*rows)[index]; }
 
     constexpr result_iterator &operator++() noexcept {
       index++;
@@ -152,8 +484,8 @@ struct spi_executor : public executor {
       return ret;
     }
 
-    constexpr result_iterator operator+(const difference_type n) const noexcept {
-      return result_iterator(tuptable, index + n);
+    result_iterator operator+(const difference_type n) const noexcept {
+      return result_iterator(rows, index + n);
     }
 
     result_iterator &operator+=(difference_type n) noexcept {
@@ -161,8 +493,8 @@ struct spi_executor : public executor {
       return *this;
     }
 
-    constexpr result_iterator operator-(difference_type n) const noexcept {
-      return result_iterator(tuptable, index - n);
+    result_iterator operator-(difference_type n) const noexcept {
+      return result_iterator(rows, index - n);
     }
 
     result_iterator &operator-=(difference_type n) noexcept {
@@ -174,70 +506,13 @@ struct spi_executor : public executor {
       return index - other.index;
     }
 
-    T &operator[](difference_type n) const {
-      if (tuples.at(n).has_value()) {
-        return tuples.at(n).value();
-      }
-      if constexpr (convertible_from_datum<T>) {
-        // if a special case of a directly convertible type
-        if constexpr (composite_type<T>) {
-          bool isnull;
-          ::Datum value =
-              ffi_guard{::SPI_getbinval}(tuptable->vals[n], tuptable->tupdesc, 1, &isnull);
-          ::NullableDatum datum = {.value = value, .isnull = isnull};
-          auto ret = from_nullable_datum<T>(nullable_datum(datum),
-                                            ffi_guard{::SPI_gettypeid}(tuptable->tupdesc, 1),
-                                            memory_context(tuptable->tuptabcxt));
-          tuples.at(n).emplace(ret);
-          return tuples.at(n).value();
-        } else if (tuptable->tupdesc->natts == 1) {
-          bool isnull;
-          ::Datum value =
-              ffi_guard{::SPI_getbinval}(tuptable->vals[n], tuptable->tupdesc, 1, &isnull);
-          ::NullableDatum datum = {.value = value, .isnull = isnull};
-          auto ret = from_nullable_datum<T>(nullable_datum(datum),
-                                            ffi_guard{::SPI_gettypeid}(tuptable->tupdesc, 1),
-                                            memory_context(tuptable->tuptabcxt));
-          tuples.at(n).emplace(ret);
-          return tuples.at(n).value();
-        }
-      }
-      if constexpr (a_vector<T>) {
-        T ret;
-        for (int i = 0; i < tuptable->tupdesc->natts; i++) {
-          bool isnull;
-          ::Datum value =
-              ffi_guard{::SPI_getbinval}(tuptable->vals[n], tuptable->tupdesc, i + 1, &isnull);
-          ::NullableDatum datum = {.value = value, .isnull = isnull};
-          auto nd = nullable_datum(datum);
-          ret.emplace_back(from_nullable_datum<typename T::value_type>(
-              nd, ffi_guard{::SPI_gettypeid}(tuptable->tupdesc, i + 1),
-              memory_context(tuptable->tuptabcxt)));
-        }
-        tuples.at(n).emplace(ret);
-      } else {
-        auto ret = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-          return T{([&] {
-            bool isnull;
-            ::Datum value =
-                ffi_guard{::SPI_getbinval}(tuptable->vals[n], tuptable->tupdesc, Is + 1, &isnull);
-            ::NullableDatum datum = {.value = value, .isnull = isnull};
-            auto nd = nullable_datum(datum);
-            return from_nullable_datum<utils::tuple_element_t<Is, T>>(
-                nd, ffi_guard{::SPI_gettypeid}(tuptable->tupdesc, Is + 1),
-                memory_context(tuptable->tuptabcxt));
-          }())...};
-        }(std::make_index_sequence<utils::tuple_size_v<T>>{});
-        tuples.at(n).emplace(ret);
-      }
-      return tuples.at(n).value();
-    }
+    T &operator[](difference_type n) const { return (*rows)[index + n]; }
 
     constexpr bool operator==(const result_iterator &other) const noexcept {
-      return tuptable == other.tuptable && index == other.index;
+      return rows == other.rows && index == other.index;
     }
     constexpr bool operator!=(const result_iterator &other) const noexcept {
-      return !(tuptable == other.tuptable && index == other.index);
+      return !(rows == other.rows && index == other.index);
     }
     constexpr bool operator<(const result_iterator &other) const noexcept {
       return index < other.index;
@@ -252,57 +527,328 @@ struct spi_executor : public executor {
       return index >= other.index;
     }
 
-    operator const heap_tuple() const { return tuptable->vals[index]; }
+    operator const heap_tuple() const { return rows->tuptable->vals[index]; }
 
   private:
+    std::shared_ptr<decoded_rows<T>> rows;
+    size_t index;
   };
 
+  /**
+   * @brief All attributes of a result, deformed once into per-column arrays
+   */
+  struct deformed_columns {
+    explicit deformed_columns(::SPITupleTable *tuptable)
+        : tuptable(tuptable), rows(tuptable->numvals), natts(tuptable->tupdesc->natts),
+          values(rows * natts), nulls(std::make_unique<bool[]>(rows * natts)) {
+      std::vector<::Datum> row_values(natts);
+      auto row_nulls = std::make_unique<bool[]>(natts);
+      for (std::size_t r = 0; r < rows; r++) {
+        ffi_unguarded{::heap_deform_tuple}(tuptable->vals[r], tuptable->tupdesc,
+                                           row_values.data(), row_nulls.get());
+        for (std::size_t c = 0; c < natts; c++) {
+          values[c * rows + r] = row_values[c];
+          nulls[c * rows + r] = row_nulls[c];
+        }
+      }
+    }
+
+    std::span<const ::Datum> column_values(std::size_t n) const {
+      return {values.data() + n * rows, rows};
+    }
+    std::span<const bool> column_nulls(std::size_t n) const {
+      return {nulls.get() + n * rows, rows};
+    }
+
+    ::SPITupleTable *tuptable;
+    std::size_t rows;
+    std::size_t natts;
+
+  private:
+    // column-major
+    std::vector<::Datum> values;
+    std::unique_ptr<bool[]> nulls;
+  };
+
+  /**
+   * @brief Column of fixed-width by-value values, converted into a contiguous array
+   *
+   * Null values are represented by a value-initialized `T` and a set flag in @ref nulls.
+   */
+  template <typename T> struct result_column {
+    /**
+     * @brief Contiguous values of the column
+     */
+    std::span<const T> values() const noexcept { return {data.get(), rows}; }
+    /**
+     * @brief Null flags of the column, one per row
+     */
+    std::span<const bool> nulls() const noexcept { return null_flags; }
+
+    std::size_t size() const noexcept { return rows; }
+    bool is_null(std::size_t n) const { return null_flags[n]; }
+    const T &operator[](std::size_t n) const { return data[n]; }
+
+  private:
+    friend struct spi_executor;
+    result_column(std::shared_ptr<T[]> data, std::size_t rows, std::span<const bool> null_flags,
+                  std::shared_ptr<deformed_columns> deformed)
+        : data(std::move(data)), rows(rows), null_flags(null_flags),
+          deformed(std::move(deformed)) {}
+
+    // not a `std::vector`, as `std::vector<bool>` isn't contiguous
+    std::shared_ptr<T[]> data;
+    std::size_t rows;
+    std::span<const bool> null_flags;
+    // keeps null flags alive
+    std::shared_ptr<deformed_columns> deformed;
+  };
+
+  /**
+   * @brief Column of values that are converted on access
+   *
+   * Used for the types that aren't fixed-width by-value (for example, `varlena` types), so
+   * that nothing is converted or copied until it is used.
+   *
+   * @note Values that refer to the results' memory (like @ref cppgres::text) are only valid as long
+   *       as the SPI results are.
+   */
+  template <typename T> struct lazy_result_column {
+    std::size_t size() const noexcept { return deformed->rows; }
+    bool is_null(std::size_t n) const { return deformed->column_nulls(column)[n]; }
+    std::span<const bool> nulls() const noexcept { return deformed->column_nulls(column); }
+
+    /**
+     * @brief Converts a value of the column, `std::nullopt` if it is null
+     */
+    std::optional<T> operator[](std::size_t n) const {
+      if (is_null(n)) {
+        return std::nullopt;
+      }
+      return from_nullable_datum<T>(nullable_datum(datum(deformed->column_values(column)[n])),
+                                    oid, memory_context(deformed->tuptable->tuptabcxt));
+    }
+
+    /**
+     * @brief View of (converted on access) values of the column
+     */
+    auto values() const {
+      return std::views::iota(std::size_t(0), size()) |
+             std::views::transform([self = *this](std::size_t n) { return self[n]; });
+    }
+
+  private:
+    friend struct spi_executor;
+    lazy_result_column(std::shared_ptr<deformed_columns> deformed, std::size_t column, ::Oid oid)
+        : deformed(std::move(deformed)), column(column), oid(oid) {}
+
+    std::shared_ptr<deformed_columns> deformed;
+    std::size_t column;
+    ::Oid oid;
+  };
+
+  template <typename T>
+  static constexpr bool fixed_width_column =
+      std::is_arithmetic_v<T> && std::is_trivially_copyable_v<T>;
+
   template <typename Ret> struct results {
     ::SPITupleTable *table;
 
     results(::SPITupleTable *table) : table(table) {
-      auto natts = table->tupdesc->natts;
-      if constexpr (a_vector<Ret>) {
-        for (int i = 0; i < natts; i++) {
-          auto oid = ffi_guard{::SPI_gettypeid}(table->tupdesc, i + 1);
-          auto t = type{.oid = oid};
-          if (!type_traits<typename Ret::value_type>().is(t)) {
-            throw std::invalid_argument(
-                cppgres::fmt::format("invalid return type in position {} ({}), got OID {}", i,
-                                     utils::type_name<typename Ret::value_type>(), oid));
+      check_result_types<Ret>(table->tupdesc);
+      rows = std::make_shared<decoded_rows<Ret>>(table);
+    }
+
+    result_iterator<Ret> begin() const { return result_iterator<Ret>(rows); }
+    size_t end() const { return count(); }
+
+    size_t count() const { return table->numvals; }
+
+    tuple_descriptor get_tuple_descriptor() const { return table->tupdesc; }
+
+    /**
+     * @brief Returns a column of the results
+     *
+     * On first use, all attributes of all rows are deformed at once into per-column arrays
+     * shared by all columns. Fixed-width by-value types (like `double` or `int64_t`) are then
+     * converted into a contiguous @ref cppgres::spi_executor::result_column, other types are
+     * returned as a @ref cppgres::spi_executor::lazy_result_column converting values on access.
+     *
+     * @param n zero-based column index
+     *
+     * @throws std::out_of_range if there's no such column
+     * @throws std::invalid_argument if the column is not of type `T`
+     */
+    template <typename T> auto column(int n) const {
+      if (n < 0 || n >= table->tupdesc->natts) {
+        throw std::out_of_range(cppgres::fmt::format(
+            "column index {} is out of bounds for results with {} columns", n,
+            table->tupdesc->natts));
+      }
+      auto oid = TupleDescAttr(table->tupdesc, n)->atttypid;
+      if (!type_traits<T>().is(type{.oid = oid})) {
+        throw std::invalid_argument(
+            cppgres::fmt::format("invalid column type in position {} ({}), got OID {}", n,
+                                 utils::type_name<T>(), oid));
+      }
+      if (deformed == nullptr) {
+        deformed = std::make_shared<deformed_columns>(table);
+      }
+      if constexpr (fixed_width_column<T>) {
+        auto values = deformed->column_values(n);
+        auto nulls = deformed->column_nulls(n);
+        auto data = std::make_shared<T[]>(values.size());
+        for (std::size_t i = 0; i < values.size(); i++) {
+          if (!nulls[i]) {
+            data[i] = from_nullable_datum<T>(nullable_datum(datum(values[i])), oid);
           }
         }
+        return result_column<T>(std::move(data), values.size(), nulls, deformed);
       } else {
-        if (natts != utils::tuple_size_v<Ret>) {
-          if (natts == 1 && convertible_from_datum<Ret>) {
-            // okay, this is just a type we can convert
-          } else {
-            throw std::runtime_error(cppgres::fmt::format("expected {} return values, got {}",
-                                                          utils::tuple_size_v<Ret>, natts));
-          }
-        } else {
-          [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-            (([&] {
-               auto oid = ffi_guard{::SPI_gettypeid}(table->tupdesc, Is + 1);
-               auto t = type{.oid = oid};
-               if (!type_traits<utils::tuple_element_t<Is, Ret>>().is(t)) {
-                 throw std::invalid_argument(cppgres::fmt::format(
-                     "invalid return type in position {} ({}), got OID {}", Is,
-                     utils::type_name<utils::tuple_element_t<Is, Ret>>(), oid));
-               }
-             }()),
-             ...);
-          }(std::make_index_sequence<utils::tuple_size_v<Ret>>{});
-        }
+        return lazy_result_column<T>(deformed, n, oid);
       }
     }
 
-    result_iterator<Ret> begin() const { return result_iterator<Ret>(table); }
-    size_t end() const { return count(); }
+  private:
+    std::shared_ptr<decoded_rows<Ret>> rows;
+    mutable std::shared_ptr<deformed_columns> deformed;
+  };
 
-    size_t count() const { return table->numvals; }
+  /**
+   * @brief Streaming query results backed by an SPI cursor
+   *
+   * A single-pass input range that fetches rows in batches of a configurable size. Every batch is
+   * released as soon as the range advances past it, so memory use is bounded by the batch size
+   * regardless of the number of rows the query produces.
+   *
+   * @note Values that refer to the results' memory (like @ref cppgres::text) are only valid until
+   *       the range advances past the batch they come from.
+   *
+   * @note Fetching requires the executor that opened the cursor to be the current one.
+   */
+  template <typename Ret> struct cursor {
+    friend struct spi_executor;
 
-    tuple_descriptor get_tuple_descriptor() const { return table->tupdesc; }
+    struct iterator {
+      using iterator_category = std::input_iterator_tag;
+      using value_type = Ret;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Ret *;
+      using reference = Ret &;
+
+      iterator() noexcept : c(nullptr) {}
+      explicit iterator(cursor *c) noexcept : c(c) {}
+
+      Ret &operator*() const { return c->current(); }
+      iterator &operator++() {
+        c->advance();
+        return *this;
+      }
+      void operator++(int) { ++*this; }
+
+      bool operator==(std::default_sentinel_t) const { return c->exhausted(); }
+
+    private:
+      cursor *c;
+    };
+
+    cursor(cursor &&other) noexcept
+        : owned(std::move(other.owned)), executor(other.executor),
+          portal_name(std::exchange(other.portal_name, {})), batch_size(other.batch_size),
+          table(std::exchange(other.table, nullptr)), batch(std::move(other.batch)),
+          rows(std::move(other.rows)), row(other.row), started(other.started),
+          last_batch(other.last_batch) {}
+
+    cursor(const cursor &) = delete;
+    cursor &operator=(const cursor &) = delete;
+    cursor &operator=(cursor &&) = delete;
+
+    ~cursor() {
+      if (table != nullptr && !executors.empty() && executors.top() == executor) {
+        // otherwise, it'll be released with the SPI connection
+        ffi_guard_noexcept([this] { ::SPI_freetuptable(table); },
+                           "failed to release cursor's tuple table");
+      }
+      if (!portal_name.empty()) {
+        ffi_guard_noexcept(
+            [this] {
+              if (auto portal = ::SPI_cursor_find(portal_name.c_str()); portal != nullptr) {
+                ::SPI_cursor_close(portal);
+              }
+            },
+            "failed to close cursor");
+      }
+    }
+
+    /**
+     * @brief Fetches the first batch, if not fetched yet
+     */
+    iterator begin() {
+      if (!started) {
+        started = true;
+        fetch();
+      }
+      return iterator(this);
+    }
+    std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+    /**
+     * @brief Returns the name of the underlying portal
+     */
+    std::string_view name() const noexcept { return portal_name; }
+
+  private:
+    cursor(spi_executor *executor, ::Portal portal, long batch_size)
+        : executor(executor), portal_name(portal->name), batch_size(batch_size) {}
+
+    Ret &current() { return rows[static_cast<std::ptrdiff_t>(row)]; }
+
+    bool exhausted() const noexcept { return table == nullptr; }
+
+    void advance() {
+      if (++row >= table->numvals) {
+        fetch();
+      }
+    }
+
+    void fetch() {
+      if (executors.empty() || executors.top() != executor) {
+        throw std::runtime_error("not a current SPI executor");
+      }
+      if (table != nullptr) {
+        batch.reset();
+        ffi_guard{::SPI_freetuptable}(std::exchange(table, nullptr));
+      }
+      if (last_batch) {
+        return;
+      }
+      auto portal = ffi_guard{::SPI_cursor_find}(portal_name.c_str());
+      if (portal == nullptr) {
+        throw std::runtime_error(fmt::format("cursor {} is gone", portal_name));
+      }
+      ffi_guard{::SPI_cursor_fetch}(portal, true, batch_size);
+      last_batch = SPI_processed < static_cast<uint64_t>(batch_size);
+      if (SPI_processed == 0) {
+        ffi_guard{::SPI_freetuptable}(SPI_tuptable);
+        return;
+      }
+      table = SPI_tuptable;
+      batch.emplace(table);
+      rows = batch->begin();
+      row = 0;
+    }
+
+    // declared first to be destroyed last
+    std::unique_ptr<spi_executor> owned;
+    spi_executor *executor;
+    std::string portal_name;
+    long batch_size;
+    ::SPITupleTable *table = nullptr;
+    std::optional<results<Ret>> batch;
+    result_iterator<Ret> rows;
+    uint64_t row = 0;
+    bool started = false;
+    bool last_batch = false;
   };
 
   struct options {
@@ -314,9 +860,60 @@ struct spi_executor : public executor {
     bool read_only() const { return read_only_; }
     int count() const { return count_; }
 
+    /**
+     * @brief Returns a copy of options that execute the query through the statement cache
+     *
+     * @see cppgres::spi_executor::statement_cache
+     */
+    options cached(spi_statement_cache::plan_choice choice =
+                       spi_statement_cache::plan_choice::automatic) const {
+      auto opts = *this;
+      opts.plan_choice_ = choice;
+      return opts;
+    }
+
+    /**
+     * @brief Plan choice if the query is to be executed through the statement cache
+     */
+    std::optional<spi_statement_cache::plan_choice> plan_choice() const { return plan_choice_; }
+
   private:
     bool read_only_;
     int count_;
+    std::optional<spi_statement_cache::plan_choice> plan_choice_;
+  };
+
+  /**
+   * @brief Backend-local statement cache used for queries executed with
+   *        @ref cppgres::spi_executor::options::cached
+   */
+  static spi_statement_cache &statement_cache() { return statements; }
+
+  /**
+   * @brief Cursor options
+   */
+  struct cursor_options {
+    explicit cursor_options() : cursor_options(1000) {}
+    /**
+     * @param batch_size number of rows fetched at once
+     * @param read_only true if the query is read-only
+     * @param flags `CURSOR_OPT_*` flags for the planner
+     */
+    cursor_options(long batch_size, bool read_only = false, int flags = 0)
+        : batch_size_(batch_size), read_only_(read_only), flags_(flags) {
+      if (batch_size <= 0) {
+        throw std::invalid_argument("cursor batch size must be positive");
+      }
+    }
+
+    long batch_size() const { return batch_size_; }
+    bool read_only() const { return read_only_; }
+    int flags() const { return flags_; }
+
+  private:
+    long batch_size_;
+    bool read_only_;
+    int flags_;
   };
 
   /**
@@ -360,9 +957,11 @@ struct spi_executor : public executor {
     auto nullable_datums = make_nullable_datums(std::forward<Args>(args)...);
     auto datums = make_datums(nullable_datums);
     auto nulls = make_nulls(nullable_datums);
-    auto rc = ffi_guard{::SPI_execute_with_args}(utils::to_cstring(query), nargs, types.data(),
-                                                 datums.data(), nulls.data(), opts.read_only(),
-                                                 opts.count());
+    auto rc = opts.plan_choice().has_value()
+                  ? execute_cached(utils::to_string_view(query), types, datums, nulls, opts)
+                  : ffi_guard{::SPI_execute_with_args}(utils::to_cstring(query), nargs,
+                                                       types.data(), datums.data(), nulls.data(),
+                                                       opts.read_only(), opts.count());
     if (rc == SPI_OK_SELECT || rc == SPI_OK_INSERT_RETURNING || rc == SPI_OK_UPDATE_RETURNING ||
         rc == SPI_OK_DELETE_RETURNING || (rc == SPI_OK_UTILITY && SPI_tuptable != nullptr)
 #if PG_MAJORVERSION_NUM >= 17
@@ -444,6 +1043,268 @@ struct spi_executor : public executor {
     }
   }
 
+  /**
+   * @brief Executes a plan once for every set of arguments in a range
+   *
+   * Argument arrays are reused across executions, and anything allocated while converting the
+   * arguments of one execution is released right after it. Results of the executions are
+   * released as soon as each execution is done.
+   *
+   * @param plan Prepared plan
+   * @param batch Range of tuple-like sets of arguments, one for each execution
+   * @param opts Execution options
+   *
+   * @return Total number of rows processed by all executions
+   *
+   * @throws std::runtime_error if there's another SPI executor in scope
+   * @throws std::runtime_error if there's an SPI error
+   */
+  template <std::ranges::input_range R, convertible_into_nullable_datum... Args>
+  uint64_t execute_batch(spi_plan<Args...> &plan, R &&batch, options &&opts = options()) {
+    uint64_t processed = 0;
+    run_batch(plan, std::forward<R>(batch), opts, [&] {
+      processed += SPI_processed;
+      ffi_guard{::SPI_freetuptable}(SPI_tuptable);
+    });
+    return processed;
+  }
+
+  /**
+   * @brief Executes a plan once for every set of arguments in a range, collecting the results
+   *
+   * Same as @ref execute_batch, but returns the rows returned by all executions.
+   *
+   * @note Returned values that refer to the results' memory (like @ref cppgres::text) stay
+   *       valid until the executor is gone.
+   */
+  template <typename Ret, std::ranges::input_range R, convertible_into_nullable_datum... Args>
+  std::vector<Ret> query_batch(spi_plan<Args...> &plan, R &&batch, options &&opts = options()) {
+    std::vector<Ret> rows;
+    run_batch(plan, std::forward<R>(batch), opts, [&] {
+      if (SPI_tuptable == nullptr) {
+        return;
+      }
+      results<Ret> res(SPI_tuptable);
+      rows.reserve(rows.size() + res.count());
+      auto it = res.begin();
+      for (std::size_t i = 0; i < res.count(); i++) {
+        rows.push_back(std::move(it[static_cast<std::ptrdiff_t>(i)]));
+      }
+    });
+    return rows;
+  }
+
+#if PG_MAJORVERSION_NUM >= 14
+  /**
+   * @brief Executes a query, passing every row to a sink as soon as it is produced
+   *
+   * Rows are sent straight from the executor to the sink through a `DestReceiver`, without
+   * being collected into an `SPITupleTable` first. Every row is decoded into `Ret` in a
+   * scratch memory context that is reset after the sink is done with it, so neither the results
+   * nor their conversions accumulate in memory.
+   *
+   * The query is prepared with the types of the arguments for this execution only, or taken
+   * from the @ref cppgres::spi_executor::statement_cache if `opts` asks for it.
+   *
+   * @param query Query string
+   * @param opts Execution options
+   * @param sink callable invoked with `Ret &` for every row, or an output iterator rows are
+   *        assigned to
+   * @param args Query arguments
+   *
+   * @return Number of rows processed
+   *
+   * @note A row (and any memory it refers to) is only valid until the sink returns.
+   * @note If the sink throws, the execution is aborted by raising a Postgres error and the
+   *       exception is then propagated out of this function. As with any other error, the
+   *       current (sub)transaction is left aborted: to keep using it, call this function in a
+   *       @ref cppgres::internal_subtransaction (or roll back to a savepoint).
+   * @note Postgres 14 and later (SPI_execute_plan_extended).
+   *
+   * @throws std::runtime_error if there's another SPI executor in scope
+   * @throws std::runtime_error if there's an SPI error
+   */
+  template <typename Ret, typename F, convertible_into_nullable_datum_and_has_a_type... Args>
+  requires result_sink<F, Ret>
+  uint64_t for_each(utils::convertible_to_cstring auto query, options &&opts, F &&sink,
+                    Args &&...args) {
+    if (executors.top() != this) {
+      throw std::runtime_error("not a current SPI executor");
+    }
+    constexpr size_t nargs = sizeof...(Args);
+    std::array<::Oid, nargs> types = {type_traits<Args>(args).type_for().oid...};
+    auto nullable_datums = make_nullable_datums(std::forward<Args>(args)...);
+    auto datums = make_datums(nullable_datums);
+    auto nulls = make_nulls(nullable_datums);
+    slot_receiver<Ret, std::remove_reference_t<F>> receiver(sink);
+    ::SPIExecuteOptions exec{};
+    exec.params = make_param_list(types, datums, nulls);
+    exec.read_only = opts.read_only();
+    exec.tcount = opts.count();
+    exec.dest = receiver;
+    auto execute = [&](::SPIPlanPtr plan) {
+      return receiver.run([&] { return ffi_guard{::SPI_execute_plan_extended}(plan, &exec); });
+    };
+    int rc;
+    if (opts.plan_choice().has_value()) {
+      rc = execute(
+          statements.prepare(utils::to_string_view(query), types, opts.plan_choice().value()));
+    } else {
+      // `SPI_execute_extended` would parse the query without the types of the parameters (the
+      // list made by `makeParamList` doesn't declare them), so it is prepared with them instead
+      auto plan = ffi_guard{::SPI_prepare}(utils::to_cstring(query), nargs, types.data());
+      if (plan == nullptr) {
+        throw std::runtime_error(
+            cppgres::fmt::format("can't prepare `{}`: {}", utils::to_string_view(query),
+                                 ::SPI_result_code_string(SPI_result)));
+      }
+      try {
+        rc = execute(plan);
+      } catch (...) {
+        ffi_guard{::SPI_freeplan}(plan);
+        throw;
+      }
+      ffi_guard{::SPI_freeplan}(plan);
+    }
+    if (rc < 0) {
+      throw std::runtime_error(
+          fmt::format("spi error in `{}`", std::string_view(utils::to_cstring(query))));
+    }
+    return SPI_processed;
+  }
+
+  template <typename Ret, typename F, convertible_into_nullable_datum_and_has_a_type... Args>
+  requires result_sink<F, Ret>
+  uint64_t for_each(utils::convertible_to_cstring auto query, F &&sink, Args &&...args) {
+    return for_each<Ret>(query, options(), std::forward<F>(sink), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Executes a plan, passing every row to a sink as soon as it is produced
+   *
+   * @see for_each
+   *
+   * @note Postgres 14 and later (SPI_execute_plan_extended).
+   */
+  template <typename Ret, typename F, convertible_into_nullable_datum... Args>
+  requires result_sink<F, Ret>
+  uint64_t for_each(spi_plan<Args...> &query, options &&opts, F &&sink, Args &&...args) {
+    if (executors.top() != this) {
+      throw std::runtime_error("not a current SPI executor");
+    }
+    constexpr size_t nargs = sizeof...(Args);
+    std::array<::Oid, nargs> types = {type_traits<Args>().type_for().oid...};
+    auto nullable_datums = make_nullable_datums(std::forward<Args>(args)...);
+    auto datums = make_datums(nullable_datums);
+    auto nulls = make_nulls(nullable_datums);
+    slot_receiver<Ret, std::remove_reference_t<F>> receiver(sink);
+    ::SPIExecuteOptions exec{};
+    exec.params = make_param_list(types, datums, nulls);
+    exec.read_only = opts.read_only();
+    exec.tcount = opts.count();
+    exec.dest = receiver;
+    auto rc =
+        receiver.run([&] { return ffi_guard{::SPI_execute_plan_extended}(query, &exec); });
+    if (rc < 0) {
+      throw std::runtime_error("spi error in a query plan");
+    }
+    return SPI_processed;
+  }
+
+  template <typename Ret, typename F, convertible_into_nullable_datum... Args>
+  requires result_sink<F, Ret>
+  uint64_t for_each(spi_plan<Args...> &query, F &&sink, Args &&...args) {
+    return for_each<Ret, F, Args...>(query, options(), std::forward<F>(sink),
+                                     std::forward<Args>(args)...);
+  }
+#endif
+
+  /**
+   * @brief Opens a cursor for a query
+   *
+   * @param query Query string
+   * @param opts Cursor options
+   * @param args Query arguments
+   *
+   * @return Streaming @ref cppgres::spi_executor::cursor
+   *
+   * @throws std::runtime_error if there's another SPI executor in scope
+   */
+  template <typename Ret, convertible_into_nullable_datum_and_has_a_type... Args>
+  cursor<Ret> open_cursor(utils::convertible_to_cstring auto query, cursor_options &&opts,
+                          Args &&...args) {
+    if (executors.top() != this) {
+      throw std::runtime_error("not a current SPI executor");
+    }
+    constexpr size_t nargs = sizeof...(Args);
+    std::array<::Oid, nargs> types = {type_traits<Args>(args).type_for().oid...};
+    auto nullable_datums = make_nullable_datums(std::forward<Args>(args)...);
+    auto datums = make_datums(nullable_datums);
+    auto nulls = make_nulls(nullable_datums);
+    auto portal = ffi_guard{::SPI_cursor_open_with_args}(
+        nullptr, utils::to_cstring(query), nargs, types.data(), datums.data(), nulls.data(),
+        opts.read_only(), opts.flags());
+    return cursor<Ret>(this, portal, opts.batch_size());
+  }
+
+  template <typename Ret, convertible_into_nullable_datum_and_has_a_type... Args>
+  cursor<Ret> open_cursor(utils::convertible_to_cstring auto query, Args &&...args) {
+    return open_cursor<Ret>(query, cursor_options(), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Opens a cursor for a prepared plan
+   *
+   * @note `flags` of @ref cppgres::spi_executor::cursor_options are not used, as the plan has
+   *       already been prepared.
+   */
+  template <typename Ret, convertible_into_nullable_datum... Args>
+  cursor<Ret> open_cursor(spi_plan<Args...> &query, cursor_options &&opts, Args &&...args) {
+    if (executors.top() != this) {
+      throw std::runtime_error("not a current SPI executor");
+    }
+    auto nullable_datums = make_nullable_datums(std::forward<Args>(args)...);
+    auto datums = make_datums(nullable_datums);
+    auto nulls = make_nulls(nullable_datums);
+    auto portal = ffi_guard{::SPI_cursor_open}(nullptr, query, datums.data(), nulls.data(),
+                                               opts.read_only());
+    return cursor<Ret>(this, portal, opts.batch_size());
+  }
+
+  template <typename Ret, convertible_into_nullable_datum... Args>
+  cursor<Ret> open_cursor(spi_plan<Args...> &query, Args &&...args) {
+    return open_cursor<Ret, Args...>(query, cursor_options(), std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Opens a cursor on a new SPI connection owned by the cursor
+   *
+   * The connection stays open for as long as the cursor lives. This allows a set-returning
+   * function to return query results as they are fetched, without collecting them first:
+   *
+   * ```cpp
+   * postgres_function(numbers, ([](int64_t n) {
+   *   return spi_executor::stream<std::tuple<int64_t>>("select generate_series(1, $1)", n);
+   * }));
+   * ```
+   *
+   * @note Since the connection must be closed before the function returns, this can't be used
+   *       with @ref cppgres::value_per_call.
+   */
+  template <typename Ret, convertible_into_nullable_datum_and_has_a_type... Args>
+  static cursor<Ret> stream(utils::convertible_to_cstring auto query, cursor_options &&opts,
+                            Args &&...args) {
+    auto spi = std::make_unique<spi_executor>();
+    auto c = spi->open_cursor<Ret>(query, std::move(opts), std::forward<Args>(args)...);
+    c.owned = std::move(spi);
+    return c;
+  }
+
+  template <typename Ret, convertible_into_nullable_datum_and_has_a_type... Args>
+  static cursor<Ret> stream(utils::convertible_to_cstring auto query, Args &&...args) {
+    return stream<Ret>(query, cursor_options(), std::forward<Args>(args)...);
+  }
+
   template <convertible_into_nullable_datum_and_has_a_type... Args>
   uint64_t execute(std::string_view query, Args &&...args) {
     return execute(query, options(), std::forward<Args>(args)...);
@@ -459,9 +1320,11 @@ struct spi_executor : public executor {
     auto nullable_datums = make_nullable_datums(std::forward<Args>(args)...);
     auto datums = make_datums(nullable_datums);
     auto nulls = make_nulls(nullable_datums);
-    auto rc = ffi_guard{::SPI_execute_with_args}(utils::to_cstring(query), nargs, types.data(),
-                                                 datums.data(), nulls.data(), opts.read_only(),
-                                                 opts.count());
+    auto rc = opts.plan_choice().has_value()
+                  ? execute_cached(query, types, datums, nulls, opts)
+                  : ffi_guard{::SPI_execute_with_args}(utils::to_cstring(query), nargs,
+                                                       types.data(), datums.data(), nulls.data(),
+                                                       opts.read_only(), opts.count());
     if (rc >= 0) {
       return SPI_processed;
     } else {
@@ -470,6 +1333,194 @@ struct spi_executor : public executor {
   }
 
 private:
+  template <std::size_t nargs>
+  static int execute_cached(std::string_view query, const std::array<::Oid, nargs> &types,
+                            std::array<::Datum, nargs> &datums,
+                            const std::array<char, nargs> &nulls, const options &opts) {
+    auto plan = statements.prepare(query, types, opts.plan_choice().value());
+    return ffi_guard{::SPI_execute_plan}(plan, datums.data(), nulls.data(), opts.read_only(),
+                                         opts.count());
+  }
+
+  template <typename R, typename Done, convertible_into_nullable_datum... Args>
+  void run_batch(spi_plan<Args...> &plan, R &&batch, const options &opts, Done &&done) {
+    if (executors.top() != this) {
+      throw std::runtime_error("not a current SPI executor");
+    }
+    constexpr std::size_t nargs = sizeof...(Args);
+    using arguments = std::tuple<Args...>;
+    ::SPIPlanPtr ptr = plan;
+    std::array<::Datum, nargs> datums{};
+    std::array<char, nargs> nulls{};
+    alloc_set_memory_context arg_context;
+
+    for (auto &&row : batch) {
+      using row_type = std::remove_cvref_t<decltype(row)>;
+      static_assert(utils::tuple_size_v<row_type> == nargs,
+                    "every set of arguments must match the arguments of the plan");
+      CHECK_FOR_INTERRUPTS();
+      int rc;
+      {
+        memory_context_scope scope(arg_context);
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+          (([&] {
+             using arg_type = std::tuple_element_t<Is, arguments>;
+             decltype(auto) value = utils::get<Is>(row);
+             nullable_datum nd = [&] {
+               if constexpr (std::same_as<std::remove_cvref_t<decltype(value)>, arg_type>) {
+                 return into_nullable_datum(value);
+               } else {
+                 return into_nullable_datum(static_cast<arg_type>(value));
+               }
+             }();
+             nulls[Is] = nd.is_null() ? 'n' : ' ';
+             datums[Is] = nd.is_null()
+                              ? ::Datum(0)
+                              : static_cast<const ::Datum &>(static_cast<const datum &>(nd));
+           }()),
+           ...);
+        }(std::make_index_sequence<nargs>{});
+        rc = ffi_guard{::SPI_execute_plan}(ptr, datums.data(), nulls.data(), opts.read_only(),
+                                           opts.count());
+      }
+      arg_context.reset();
+      if (rc < 0) {
+        throw std::runtime_error("spi error in a query plan");
+      }
+      done();
+    }
+  }
+
+#if PG_MAJORVERSION_NUM >= 14
+  template <std::size_t nargs>
+  static ::ParamListInfo make_param_list(const std::array<::Oid, nargs> &types,
+                                         const std::array<::Datum, nargs> &datums,
+                                         const std::array<char, nargs> &nulls) {
+    if constexpr (nargs == 0) {
+      return nullptr;
+    } else {
+      ::ParamListInfo params = ffi_guard{::makeParamList}(nargs);
+      for (std::size_t i = 0; i < nargs; i++) {
+        params->params[i] = {.value = datums[i],
+                             .isnull = nulls[i] == 'n',
+                             .pflags = PARAM_FLAG_CONST,
+                             .ptype = types[i]};
+      }
+      return params;
+    }
+  }
+
+  /**
+   * @brief `DestReceiver` decoding every received slot and passing it to a sink
+   */
+  template <typename Ret, typename F> struct slot_receiver {
+    explicit slot_receiver(F &sink) : sink(sink) {
+      receiver.pub.receiveSlot = receive;
+      receiver.pub.rStartup = startup;
+      receiver.pub.rShutdown = [](::DestReceiver *) {};
+      receiver.pub.rDestroy = [](::DestReceiver *) {};
+      receiver.pub.mydest = DestNone;
+      receiver.self = this;
+    }
+
+    slot_receiver(const slot_receiver &) = delete;
+    slot_receiver &operator=(const slot_receiver &) = delete;
+
+    operator ::DestReceiver *() noexcept { return &receiver.pub; }
+
+    /**
+     * @brief Runs the execution, rethrowing the exception that aborted it, if any
+     */
+    template <typename Exec> int run(Exec &&exec) {
+      try {
+        return exec();
+      } catch (pg_exception &) {
+        if (error) {
+          std::rethrow_exception(error);
+        }
+        throw;
+      }
+    }
+
+  private:
+    struct dest_receiver {
+      // must be the first member
+      ::DestReceiver pub;
+      slot_receiver *self;
+    };
+
+    static slot_receiver &from(::DestReceiver *dest) {
+      return *reinterpret_cast<dest_receiver *>(dest)->self;
+    }
+
+    // These are called by the executor: no C++ objects must be alive when an error is reported
+
+    static void startup(::DestReceiver *dest, int, ::TupleDesc tupdesc) {
+      auto &self = from(dest);
+      if (!self.start(tupdesc)) {
+        report(ERROR, "%s", self.message.c_str());
+      }
+    }
+
+    static bool receive(::TupleTableSlot *slot, ::DestReceiver *dest) {
+      auto &self = from(dest);
+      ::slot_getallattrs(slot);
+      if (!self.consume(slot)) {
+        report(ERROR, "%s", self.message.c_str());
+      }
+      return true;
+    }
+
+    bool start(::TupleDesc tupdesc) noexcept {
+      return capture([&] {
+        check_result_types<Ret>(tupdesc);
+        types.resize(tupdesc->natts);
+        for (std::size_t i = 0; i < types.size(); i++) {
+          types[i] = TupleDescAttr(tupdesc, i)->atttypid;
+        }
+      });
+    }
+
+    bool consume(::TupleTableSlot *slot) noexcept {
+      return capture([&] {
+        {
+          memory_context_scope scope(row_context);
+          auto ctx = memory_context(static_cast<::MemoryContext>(row_context));
+          Ret row = decode_row<Ret>(slot->tts_values, slot->tts_isnull, types, ctx);
+          if constexpr (std::invocable<F &, Ret &>) {
+            sink(row);
+          } else {
+            *sink = row;
+            ++sink;
+          }
+        }
+        row_context.reset();
+      });
+    }
+
+    template <typename Fn> bool capture(Fn &&fn) noexcept {
+      try {
+        fn();
+        return true;
+      } catch (const std::exception &e) {
+        error = std::current_exception();
+        message = e.what();
+      } catch (...) {
+        error = std::current_exception();
+        message = "some exception occurred";
+      }
+      return false;
+    }
+
+    dest_receiver receiver;
+    F &sink;
+    std::vector<::Oid> types;
+    alloc_set_memory_context row_context;
+    std::exception_ptr error;
+    std::string message;
+  };
+#endif
+
   template <convertible_into_nullable_datum... Args>
   static auto make_nullable_datums(Args &&...args) {
     return std::array<nullable_datum, sizeof...(Args)>{
@@ -500,6 +1551,8 @@ private:
   ::MemoryContext before_spi;
   ::MemoryContext spi;
 
+  static inline spi_statement_cache statements;
+
 protected:
   static inline std::stack<spi_executor *> executors;
   spi_executor(int flags) : before_spi(::CurrentMemoryContext) {
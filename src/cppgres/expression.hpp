@@ -0,0 +1,215 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datum.hpp"
+#include "guard.hpp"
+#include "imports.h"
+#include "memory.hpp"
+#include "resource_owner.hpp"
+#include "types.hpp"
+#include "utils/utils.hpp"
+
+extern "C" {
+#include <jit/jit.h>
+#include <optimizer/optimizer.h>
+}
+
+#include <array>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace cppgres {
+
+/**
+ * @brief SQL expression compiled once and evaluated many times
+ *
+ * The expression is parsed, analyzed and planned once, with the types of `Args` as the types of
+ * its parameters (`$1`, `$2`, ...), and compiled into an `ExprState`. Every evaluation only binds
+ * the arguments and runs the compiled expression in a per-tuple memory context that is reset
+ * before the next evaluation.
+ *
+ * If JIT compilation is enabled (`jit` and `jit_expressions`), the expression is compiled with
+ * it as well.
+ *
+ * Only scalar expressions are accepted: no relations, aggregates, window functions, set-returning
+ * functions or subqueries.
+ *
+ * @note Values of pass-by-reference types returned by an evaluation (such as `std::string_view`)
+ *       are only valid until the next evaluation.
+ * @note The expression (and its JIT-compiled code) must not outlive the transaction it was
+ *       created in.
+ *
+ * @tparam Ret result type
+ * @tparam Args parameter types
+ */
+template <has_type_traits Ret, has_type_traits... Args> struct expression {
+
+  /**
+   * @brief Compiles an expression
+   *
+   * @param text SQL expression
+   * @param jit allow JIT compilation if it is enabled
+   *
+   * @throws std::invalid_argument if `text` is not a scalar expression
+   * @throws std::runtime_error if the type of the expression is not compatible with `Ret`
+   */
+  explicit expression(std::string_view text, bool jit = true) {
+    ::EState *es = estate;
+    memory_context_scope scope(memory_context(es->es_query_cxt));
+
+    std::array<::Oid, sizeof...(Args)> argtypes = {type_traits<Args>().type_for().oid...};
+    auto source = cppgres::fmt::format("SELECT ({})", text);
+
+#if PG_MAJORVERSION_NUM >= 14
+    ::List *raw = ffi_guard{::raw_parser}(source.c_str(), RAW_PARSE_DEFAULT);
+#else
+    ::List *raw = ffi_guard{::raw_parser}(source.c_str());
+#endif
+    if (list_length(raw) != 1) {
+      throw std::invalid_argument(cppgres::fmt::format("`{}` is not a scalar expression", text));
+    }
+#if PG_MAJORVERSION_NUM >= 15
+    ::Query *query = ffi_guard{::parse_analyze_fixedparams}(
+        linitial_node(RawStmt, raw), source.c_str(), argtypes.data(),
+        static_cast<int>(argtypes.size()), nullptr);
+#else
+    ::Query *query =
+        ffi_guard{::parse_analyze}(linitial_node(RawStmt, raw), source.c_str(), argtypes.data(),
+                                   static_cast<int>(argtypes.size()), nullptr);
+#endif
+    if (query->commandType != CMD_SELECT || query->utilityStmt != nullptr ||
+        query->rtable != NIL || query->jointree->fromlist != NIL ||
+        query->jointree->quals != nullptr || query->hasAggs || query->hasWindowFuncs ||
+        query->hasTargetSRFs || query->hasSubLinks || query->cteList != NIL ||
+        query->setOperations != nullptr || query->groupClause != NIL ||
+        query->havingQual != nullptr || query->distinctClause != NIL ||
+        query->sortClause != NIL || query->limitCount != nullptr ||
+        query->limitOffset != nullptr || list_length(query->targetList) != 1) {
+      throw std::invalid_argument(cppgres::fmt::format("`{}` is not a scalar expression", text));
+    }
+
+    auto *expr = linitial_node(TargetEntry, query->targetList)->expr;
+    rettype = ffi_guard{::exprType}(reinterpret_cast<::Node *>(expr));
+    if (!type_traits<Ret>().is(type{.oid = rettype})) {
+      throw std::runtime_error(cppgres::fmt::format("expected expression of type {}, got {}",
+                                                    type_traits<Ret>().type_for().name(),
+                                                    type{.oid = rettype}.name()));
+    }
+    expr = ffi_guard{::expression_planner}(expr);
+
+    if (jit && ::jit_enabled && ::jit_expressions) {
+      // The expression is going to be evaluated many times, so there is no point in weighing
+      // the cost thresholds used by the planner
+      es->es_jit_flags = PGJIT_PERFORM | PGJIT_EXPR;
+      if (::jit_optimize_above_cost >= 0) {
+        es->es_jit_flags |= PGJIT_OPT3;
+      }
+      if (::jit_inline_above_cost >= 0) {
+        es->es_jit_flags |= PGJIT_INLINE;
+      }
+    }
+
+    // Parameters are read from the expression context when the expression is evaluated
+    params = ffi_guard{::makeParamList}(sizeof...(Args));
+    for (std::size_t i = 0; i < sizeof...(Args); i++) {
+      params->params[i] = {.isnull = true, .pflags = PARAM_FLAG_CONST, .ptype = argtypes[i]};
+    }
+    es->es_param_list_info = params;
+
+    // Expressions only get JIT-compiled when they have a parent plan state (that gives access to
+    // the executor state)
+    auto *parent = makeNode(ResultState);
+    parent->ps.state = es;
+
+    state = ffi_guard{::ExecInitExpr}(expr, &parent->ps);
+    econtext = ffi_guard{::CreateExprContext}(es);
+  }
+
+  expression(const expression &) = delete;
+  expression &operator=(const expression &) = delete;
+  expression(expression &&) = default;
+  expression &operator=(expression &&) = default;
+
+  /**
+   * @brief Evaluates the expression
+   */
+  Ret operator()(const Args &...args) {
+    ffi_guard{::MemoryContextReset}(econtext->ecxt_per_tuple_memory);
+    memory_context_scope scope(memory_context(econtext->ecxt_per_tuple_memory));
+
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      (([&] {
+         nullable_datum nd = into_nullable_datum(args);
+         auto &param = params->params[I];
+         param.isnull = nd.is_null();
+         param.value = nd.is_null() ? ::Datum(0)
+                                    : static_cast<const ::Datum &>(static_cast<const datum &>(nd));
+       }()),
+       ...);
+    }(std::make_index_sequence<sizeof...(Args)>{});
+
+    bool isnull;
+    ::Datum value =
+        ffi_guard{[this, &isnull]() { return ExecEvalExpr(state, econtext, &isnull); }}();
+    nullable_datum result = isnull ? nullable_datum() : nullable_datum(value);
+    return datum_conversion<Ret>().from_nullable_datum(
+        result, rettype, memory_context(econtext->ecxt_per_tuple_memory));
+  }
+
+  /**
+   * @brief Evaluates the expression for every element of `inputs`, writing results into `out`
+   *
+   * Elements are either the expression's parameter (for expressions with one parameter) or
+   * tuple-like values holding all of the parameters.
+   *
+   * @returns output iterator past the last written result
+   */
+  template <std::ranges::input_range R, std::output_iterator<Ret> O>
+  O transform(R &&inputs, O out) {
+    for (auto &&input : inputs) {
+      CHECK_FOR_INTERRUPTS();
+      if constexpr (requires { std::tuple_size<std::remove_cvref_t<decltype(input)>>::value; }) {
+        *out = std::apply(*this, input);
+      } else {
+        *out = (*this)(input);
+      }
+      ++out;
+    }
+    return out;
+  }
+
+  /**
+   * @brief Evaluates the expression for every element of `inputs`
+   *
+   * @see transform(R &&, O)
+   */
+  template <std::ranges::input_range R> std::vector<Ret> transform(R &&inputs) {
+    std::vector<Ret> results;
+    if constexpr (std::ranges::sized_range<R>) {
+      results.reserve(std::ranges::size(inputs));
+    }
+    transform(std::forward<R>(inputs), std::back_inserter(results));
+    return results;
+  }
+
+  /**
+   * @brief Type of the expression
+   */
+  type result_type() const { return type{.oid = rettype}; }
+
+private:
+  executor_state estate;
+  ::ParamListInfo params = nullptr;
+  ::ExprState *state = nullptr;
+  ::ExprContext *econtext = nullptr;
+  oid rettype = InvalidOid;
+};
+
+} // namespace cppgres
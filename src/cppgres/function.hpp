@@ -17,9 +17,14 @@
 #include <array>
 #include <complex>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
 #include <stack>
 #include <tuple>
 #include <typeinfo>
+#include <vector>
 
 namespace cppgres {
 
@@ -163,16 +168,40 @@ template <datumable_function Func> struct postgres_function {
   using return_type = utils::function_traits::invoke_result_from_tuple_t<Func, argument_types>;
   static constexpr std::size_t arity = traits::arity;
 
+  /**
+   * @brief Call site information resolved once per `FmgrInfo`
+   *
+   * Return and argument types and set-returning status can't change between calls made
+   * through the same `FmgrInfo`, so they are resolved and validated on the first call and kept
+   * in `flinfo->fn_extra` (allocated in `flinfo->fn_mcxt`). Subsequent calls go straight to
+   * argument conversion and invocation.
+   *
+   * @note This means `fn_extra` of functions wrapped by @ref cppgres::postgres_function
+   *       is reserved for Cppgres' own use.
+   */
+  struct call_plan {
+    type rettype;
+    bool retset;
+    std::array<type, arity> argtypes;
+    /**
+     * @brief State of the value-per-call set being returned, if any
+     */
+    void *set_state = nullptr;
+    /**
+     * @brief Row descriptor of the set, once it has been checked against the C++ row type
+     *
+     * For materialized sets this is the caller's expected descriptor; for value-per-call sets,
+     * the blessed result descriptor (allocated in `fn_mcxt`), reused across rescans.
+     */
+    ::TupleDesc row_desc = nullptr;
+  };
+
   /**
    * Invoke the function as per Postgres convention
    */
   auto operator()(FunctionCallInfo fc) -> ::Datum {
 
     return exception_guard([&] {
-      // return type
-      auto rettype = type{.oid = ffi_guard{::get_fn_expr_rettype}(fc->flinfo)};
-      auto retset = fc->flinfo->fn_retset;
-
       if constexpr (datumable_iterator<return_type>) {
         // Check this before checking the type of `retset`
         auto rsinfo = reinterpret_cast<::ReturnSetInfo *>(fc->resultinfo);
@@ -181,68 +210,27 @@ template <datumable_function Func> struct postgres_function {
         }
       }
 
-      if (!OidIsValid(rettype.oid)) {
-        // TODO: not very efficient to look it up every time
-        syscache<Form_pg_proc, oid> cache(fc->flinfo->fn_oid);
-        rettype = type{.oid = (*cache).prorettype};
-        retset = (*cache).proretset;
-      }
+      auto &plan = resolve_call_plan(fc);
 
-      if (retset) {
-        if constexpr (datumable_iterator<return_type>) {
-          using set_value_type = set_iterator_traits<return_type>::value_type;
-          if (!type_traits<set_value_type>().is(rettype)) {
-            report(ERROR, "unexpected set's return type, can't convert `%s` into `%.*s`",
-                   rettype.name().data(), utils::type_name<set_value_type>().length(),
-                   utils::type_name<set_value_type>().data());
+      if constexpr (value_per_call_set<return_type>) {
+        auto rsinfo = reinterpret_cast<::ReturnSetInfo *>(fc->resultinfo);
+        if ((rsinfo->allowedModes & SFRM_ValuePerCall) != 0) {
+          auto call_handle = current_postgres_function::push(fc);
+          if (plan.set_state == nullptr) {
+            start_value_per_call(fc, rsinfo, plan);
           }
-        } else {
-          report(ERROR,
-                 "unexpected return type, set is expected, but `%.*s` does not conform to "
-                 "`cppgres::datumable_iterator`",
-                 utils::type_name<return_type>().length(), utils::type_name<return_type>().data());
+          return next_value_per_call(fc, rsinfo, plan);
         }
-      } else if (!type_traits<return_type>().is(rettype)) {
-        report(ERROR, "unexpected return type, can't convert `%s` into `%.*s`",
-               rettype.name().data(), utils::type_name<return_type>().length(),
-               utils::type_name<return_type>().data());
-      }
-
-      // arguments
-      if (fc->nargs < arity) {
-        report(ERROR, "expected %d arguments, got %d instead", arity, fc->nargs);
-      }
-      short accounted_for_args = 0;
-      auto t = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-        return argument_types{([&]() -> utils::tuple_element_t<Is, argument_types> {
-          using ptyp = utils::tuple_element_t<Is, argument_types>;
-          auto typ = type{.oid = ffi_guard{::get_fn_expr_argtype}(fc->flinfo, Is)};
-          if (!OidIsValid(typ.oid)) {
-            // TODO: not very efficient to look it up every time
-            syscache<Form_pg_proc, oid> cache(fc->flinfo->fn_oid);
-            if ((*cache).proargtypes.dim1 > Is) {
-              typ = type{.oid = (*cache).proargtypes.values[Is]};
-            }
-          }
-          if (!type_traits<ptyp>().is(typ)) {
-            report(ERROR, "unexpected type in position %d, can't convert `%s` into `%.*s`", Is,
-                   typ.name().data(), utils::type_name<ptyp>().length(),
-                   utils::type_name<ptyp>().data());
-          }
-          accounted_for_args++;
-          return from_nullable_datum<ptyp>(nullable_datum(fc->args[Is]), typ.oid);
-        }())...};
-      }(std::make_index_sequence<utils::tuple_size_v<argument_types>>{});
-
-      if (arity != accounted_for_args) {
-        report(ERROR, "expected %d arguments, got %d instead", arity, accounted_for_args);
       }
 
+      // Pushed before converting the arguments, so conversions can see the call (for example, to
+      // find the aggregate memory context)
       auto call_handle = current_postgres_function::push(fc);
 
+      auto t = convert_arguments(fc, plan);
+
       if constexpr (datumable_iterator<return_type>) {
         auto rsinfo = reinterpret_cast<::ReturnSetInfo *>(fc->resultinfo);
-        // TODO: For now, let's assume materialized model
         using set_value_type = set_iterator_traits<return_type>::value_type;
         if constexpr (std::same_as<set_value_type, record>) {
 
@@ -283,27 +271,11 @@ template <datumable_function Func> struct postgres_function {
         } else {
           constexpr auto nargs = utils::tuple_size_v<set_value_type>;
 
-          auto natts = rsinfo->expectedDesc->natts;
-
-          if (nargs != natts) {
-            throw std::runtime_error(cppgres::fmt::format("expected set with {} value{}, got {} instead",
-                                                 nargs, nargs == 1 ? "" : "s", natts));
+          if (plan.row_desc != rsinfo->expectedDesc) {
+            check_set_descriptor(rsinfo->expectedDesc);
+            plan.row_desc = rsinfo->expectedDesc;
           }
 
-          [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-            (([&] {
-               auto oid = ffi_guard{::SPI_gettypeid}(rsinfo->expectedDesc, Is + 1);
-               auto t = type{.oid = oid};
-               using typ = utils::tuple_element_t<Is, set_value_type>;
-               if (!type_traits<typ>().is(t)) {
-                 throw std::invalid_argument(
-                     cppgres::fmt::format("invalid type in record's position {} ({}), got OID {}", Is,
-                                 utils::type_name<typ>(), oid));
-               }
-             }()),
-             ...);
-          }(std::make_index_sequence<nargs>{});
-
           rsinfo->returnMode = SFRM_Materialize;
 
           memory_context_scope scope(memory_context(rsinfo->econtext->ecxt_per_query_memory));
@@ -315,20 +287,22 @@ template <datumable_function Func> struct postgres_function {
 
           auto result = std::apply(func, t);
 
+          // Conversions of every row are allocated in this context and released as soon as the
+          // row has been copied into the tuplestore, so that memory usage doesn't grow with the
+          // number of rows. Resetting a context nothing was allocated in is effectively free.
+          alloc_set_memory_context row_context;
+          std::array<::Datum, nargs> values;
+          std::array<bool, nargs> isnull;
+
           for (auto it : result) {
             CHECK_FOR_INTERRUPTS();
-            std::array<::Datum, nargs> values = std::apply(
-                [](auto &&...elems) -> std::array<::Datum, sizeof...(elems)> {
-                  return {into_nullable_datum(elems)...};
-                },
-                utils::tie(it));
-            std::array<bool, nargs> isnull = std::apply(
-                [](auto &&...elems) -> std::array<bool, sizeof...(elems)> {
-                  return {into_nullable_datum(elems).is_null()...};
-                },
-                utils::tie(it));
-            ffi_guard{::tuplestore_putvalues}(tupstore, rsinfo->expectedDesc, values.data(),
-                                              isnull.data());
+            {
+              memory_context_scope row_scope(row_context);
+              row_schema<set_value_type>::into_datums(it, values, isnull);
+              ffi_guard{::tuplestore_putvalues}(tupstore, rsinfo->expectedDesc, values.data(),
+                                                isnull.data());
+            }
+            row_context.reset();
           }
 
           fc->isnull = true;
@@ -351,6 +325,249 @@ template <datumable_function Func> struct postgres_function {
     })();
     __builtin_unreachable();
   }
+
+private:
+  static argument_types convert_arguments(FunctionCallInfo fc, const call_plan &plan) {
+    return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      return argument_types{from_nullable_datum<utils::tuple_element_t<Is, argument_types>>(
+          nullable_datum(fc->args[Is]), plan.argtypes[Is].oid)...};
+    }(std::make_index_sequence<utils::tuple_size_v<argument_types>>{});
+  }
+
+  /**
+   * @brief Checks that set's tuple-like values match the expected tuple descriptor
+   */
+  static void check_set_descriptor(::TupleDesc desc) {
+    using set_value_type = set_iterator_traits<return_type>::value_type;
+    constexpr auto nargs = utils::tuple_size_v<set_value_type>;
+
+    auto natts = desc->natts;
+
+    if (nargs != natts) {
+      throw std::runtime_error(cppgres::fmt::format("expected set with {} value{}, got {} instead",
+                                                    nargs, nargs == 1 ? "" : "s", natts));
+    }
+
+    row_schema<set_value_type>::check(desc);
+  }
+
+  /**
+   * @brief Value-per-call set state, kept across calls in its own memory context
+   */
+  template <datumable_iterator R> struct value_per_call_state {
+    value_per_call_state(argument_types &&args, Func &func, ::MemoryContext context,
+                         ::TupleDesc tupdesc)
+        : args(std::move(args)), range(std::apply(func, this->args)),
+          it(std::begin(range)), end(std::end(range)), context(context), tupdesc(tupdesc) {}
+
+    argument_types args;
+    R range;
+    decltype(std::begin(std::declval<R &>())) it;
+    decltype(std::end(std::declval<R &>())) end;
+    bool started = false;
+    bool checked = false;
+    ::MemoryContext context;
+    /**
+     * @brief Blessed descriptor of composite rows, `nullptr` for scalar sets
+     */
+    ::TupleDesc tupdesc;
+  };
+
+  /**
+   * @brief Invokes the function and sets up value-per-call state for subsequent calls
+   */
+  void start_value_per_call(FunctionCallInfo fc, ::ReturnSetInfo *rsinfo, call_plan &plan) {
+    using state = value_per_call_state<return_type>;
+    using set_value_type = set_iterator_traits<return_type>::value_type;
+
+    // The result descriptor of a call site doesn't change between rescans, so it is resolved,
+    // checked and blessed only once
+    if (plan.row_desc == nullptr && ffi_guard{::type_is_rowtype}(plan.rettype.oid)) {
+      memory_context_scope scope(memory_context(fc->flinfo->fn_mcxt));
+      ::TupleDesc tupdesc = nullptr;
+      if (ffi_guard{::get_call_result_type}(fc, nullptr, &tupdesc) != TYPEFUNC_COMPOSITE) {
+        report(ERROR, "function returning record called in context that cannot accept type "
+                      "record");
+      }
+      if constexpr (!std::same_as<set_value_type, record>) {
+        check_set_descriptor(tupdesc);
+      }
+      plan.row_desc = ffi_guard{::BlessTupleDesc}(tupdesc);
+    }
+
+    // Same arrangement as `multi_call_memory_ctx` in `funcapi.h`
+    auto ctx = memory_context(std::move(
+        alloc_set_memory_context(memory_context(rsinfo->econtext->ecxt_per_query_memory))));
+
+    {
+      // Arguments are converted in the set's context too: whatever their conversion allocates
+      // (such as detoasted values) must outlive the per-tuple context of this call
+      memory_context_scope scope(ctx);
+      auto t = convert_arguments(fc, plan);
+      plan.set_state = ctx.construct<state>(std::move(t), func, ctx, plan.row_desc);
+    }
+
+    ffi_guard{::RegisterExprContextCallback}(rsinfo->econtext, shutdown_value_per_call,
+                                             PointerGetDatum(&plan));
+  }
+
+  /**
+   * @brief Tears down value-per-call state when the executor stops calling the function
+   *
+   * Registered as an expression context callback, so it runs at executor shutdown or rescan
+   * even if the set was not read to the end.
+   */
+  static void shutdown_value_per_call(::Datum arg) {
+    auto *plan = reinterpret_cast<call_plan *>(DatumGetPointer(arg));
+    auto *state = static_cast<value_per_call_state<return_type> *>(plan->set_state);
+    plan->set_state = nullptr;
+    if (state != nullptr) {
+      // runs the state's destructor via the reset callback registered by `construct`
+      ::MemoryContextDelete(state->context);
+    }
+  }
+
+  static ::Datum next_value_per_call(FunctionCallInfo fc, ::ReturnSetInfo *rsinfo,
+                                     call_plan &plan) {
+    using set_value_type = set_iterator_traits<return_type>::value_type;
+    auto *state = static_cast<value_per_call_state<return_type> *>(plan.set_state);
+
+    std::optional<set_value_type> row;
+    {
+      // Anything the range allocates while advancing must survive until the next call
+      memory_context_scope scope(memory_context(state->context));
+      if (state->started) {
+        ++state->it;
+      } else {
+        state->started = true;
+      }
+      if (state->it != state->end) {
+        row.emplace(*state->it);
+      }
+    }
+
+    if (!row.has_value()) {
+      ffi_guard{::UnregisterExprContextCallback}(rsinfo->econtext, shutdown_value_per_call,
+                                                 PointerGetDatum(&plan));
+      shutdown_value_per_call(PointerGetDatum(&plan));
+      rsinfo->isDone = ExprEndResult;
+      fc->isnull = true;
+      return ::Datum(0);
+    }
+
+    rsinfo->isDone = ExprMultipleResult;
+
+    if constexpr (std::same_as<set_value_type, record>) {
+      if (!state->checked) {
+        if (row->attributes() != state->tupdesc->natts) {
+          throw std::runtime_error(cppgres::fmt::format(
+              "expected record with {} value{}, got {} instead", state->tupdesc->natts,
+              state->tupdesc->natts == 1 ? "" : "s", row->attributes()));
+        }
+        if (!row->get_tuple_descriptor().equal_types(tuple_descriptor(state->tupdesc))) {
+          throw std::runtime_error("expected and returned records do not match");
+        }
+        state->checked = true;
+      }
+      return ffi_guard{::heap_copy_tuple_as_datum}(*row, state->tupdesc);
+    } else {
+      constexpr auto nargs = utils::tuple_size_v<set_value_type>;
+      std::array<::Datum, nargs> values;
+      std::array<bool, nargs> isnull;
+      row_schema<set_value_type>::into_datums(*row, values, isnull);
+
+      if (state->tupdesc == nullptr) {
+        if constexpr (nargs == 1) {
+          fc->isnull = isnull[0];
+          return values[0];
+        } else {
+          report(ERROR, "expected a composite return type for a set of %d values", nargs);
+        }
+      }
+
+      ::HeapTuple tuple =
+          ffi_guard{::heap_form_tuple}(state->tupdesc, values.data(), isnull.data());
+      return HeapTupleGetDatum(tuple);
+    }
+  }
+
+  static void check_nargs(FunctionCallInfo fc) {
+    if (fc->nargs < arity) {
+      report(ERROR, "expected %d arguments, got %d instead", arity, fc->nargs);
+    }
+  }
+
+  /**
+   * @brief Returns the call plan cached in `fn_extra`, resolving and validating it on first call
+   */
+  static call_plan &resolve_call_plan(FunctionCallInfo fc) {
+    if (fc->flinfo->fn_extra != nullptr) {
+      check_nargs(fc);
+      return *static_cast<call_plan *>(fc->flinfo->fn_extra);
+    }
+
+    call_plan plan{.rettype = type{.oid = ffi_guard{::get_fn_expr_rettype}(fc->flinfo)},
+                   .retset = fc->flinfo->fn_retset};
+
+    // Resolved lazily, only when the call expression doesn't carry the types
+    std::optional<syscache<Form_pg_proc, oid>> proc;
+
+    if (!OidIsValid(plan.rettype.oid)) {
+      proc.emplace(fc->flinfo->fn_oid);
+      plan.rettype = type{.oid = (**proc).prorettype};
+      plan.retset = (**proc).proretset;
+    }
+
+    if (plan.retset) {
+      if constexpr (datumable_iterator<return_type>) {
+        using set_value_type = set_iterator_traits<return_type>::value_type;
+        if (!type_traits<set_value_type>().is(plan.rettype)) {
+          report(ERROR, "unexpected set's return type, can't convert `%s` into `%.*s`",
+                 plan.rettype.name().data(), utils::type_name<set_value_type>().length(),
+                 utils::type_name<set_value_type>().data());
+        }
+      } else {
+        report(ERROR,
+               "unexpected return type, set is expected, but `%.*s` does not conform to "
+               "`cppgres::datumable_iterator`",
+               utils::type_name<return_type>().length(), utils::type_name<return_type>().data());
+      }
+    } else if (!type_traits<return_type>().is(plan.rettype)) {
+      report(ERROR, "unexpected return type, can't convert `%s` into `%.*s`",
+             plan.rettype.name().data(), utils::type_name<return_type>().length(),
+             utils::type_name<return_type>().data());
+    }
+
+    check_nargs(fc);
+
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (([&] {
+         using ptyp = utils::tuple_element_t<Is, argument_types>;
+         auto typ = type{.oid = ffi_guard{::get_fn_expr_argtype}(fc->flinfo, Is)};
+         if (!OidIsValid(typ.oid)) {
+           if (!proc.has_value()) {
+             proc.emplace(fc->flinfo->fn_oid);
+           }
+           if ((**proc).proargtypes.dim1 > Is) {
+             typ = type{.oid = (**proc).proargtypes.values[Is]};
+           }
+         }
+         if (!type_traits<ptyp>().is(typ)) {
+           report(ERROR, "unexpected type in position %d, can't convert `%s` into `%.*s`", Is,
+                  typ.name().data(), utils::type_name<ptyp>().length(),
+                  utils::type_name<ptyp>().data());
+         }
+         plan.argtypes[Is] = typ;
+       }()),
+       ...);
+    }(std::make_index_sequence<arity>{});
+
+    // Only cache the plan once it has been fully validated
+    auto *cached = memory_context(fc->flinfo->fn_mcxt).alloc<call_plan>();
+    *cached = plan;
+    fc->flinfo->fn_extra = cached;
+    return *cached;
+  }
 };
 
 template <has_type_traits ret_type, has_type_traits... arg_types> struct function {
@@ -423,8 +640,121 @@ template <has_type_traits ret_type, has_type_traits... arg_types> struct functio
       }(std::make_index_sequence<sizeof...(Args)>{});
     }
   }
+  /**
+   * @brief Calls the function
+   *
+   * The function's `FmgrInfo` and call frame are resolved on the first call and reused by all
+   * subsequent calls (including calls through copies of this object).
+   */
   ret_type operator()(auto... args) requires(self::convertible_args<decltype(args)...>())
   {
+    auto f = frame();
+    if (f->busy) {
+      // Re-entrant call (the function ended up calling itself through this object): the shared
+      // call frame is still in use, so use a local one
+      LOCAL_FCINFO(fcinfo, sizeof...(arg_types));
+      InitFunctionCallInfoData(*fcinfo, f->flinfo, sizeof...(arg_types), InvalidOid, nullptr,
+                               nullptr);
+      return invoke(fcinfo, args...);
+    }
+    busy_scope busy(f);
+    return invoke(f->fcinfo, args...);
+  }
+
+  /**
+   * @brief Calls the function for every element of `inputs`, writing results into `out`
+   *
+   * Elements are either the function's argument (for functions of one argument) or tuple-like
+   * values holding all of the arguments.
+   *
+   * @returns output iterator past the last written result
+   */
+  template <std::ranges::input_range R, std::output_iterator<ret_type> O>
+  O transform(R &&inputs, O out) {
+    auto f = frame();
+    std::optional<busy_scope> busy;
+    ::FunctionCallInfo fcinfo;
+    LOCAL_FCINFO(local_fcinfo, sizeof...(arg_types));
+    if (f->busy) {
+      InitFunctionCallInfoData(*local_fcinfo, f->flinfo, sizeof...(arg_types), InvalidOid,
+                               nullptr, nullptr);
+      fcinfo = local_fcinfo;
+    } else {
+      busy.emplace(f);
+      fcinfo = f->fcinfo;
+    }
+    for (auto &&input : inputs) {
+      if constexpr (requires { std::tuple_size<std::remove_cvref_t<decltype(input)>>::value; }) {
+        *out = std::apply([&](auto &&...args) { return invoke(fcinfo, args...); }, input);
+      } else {
+        *out = invoke(fcinfo, input);
+      }
+      ++out;
+    }
+    return out;
+  }
+
+  /**
+   * @brief Calls the function for every element of `inputs`
+   *
+   * @see transform(R &&, O)
+   */
+  template <std::ranges::input_range R> std::vector<ret_type> transform(R &&inputs) {
+    std::vector<ret_type> results;
+    if constexpr (std::ranges::sized_range<R>) {
+      results.reserve(std::ranges::size(inputs));
+    }
+    transform(std::forward<R>(inputs), std::back_inserter(results));
+    return results;
+  }
+
+  /**
+   * @brief Sets the memory context the function's `FmgrInfo` and call frame are kept in
+   *
+   * By default, they are kept in the memory context that is current at the time of the first
+   * call. If that memory context is reset, they are resolved again on the next call.
+   */
+  self &cache_in(memory_context ctx) {
+    cache_context_ = ctx;
+    frame_.reset();
+    return *this;
+  }
+
+  const oid &function_oid() const { return oid_; }
+
+private:
+  struct call_frame {
+    explicit call_frame(memory_context ctx) : ctx(tracking_memory_context(ctx)) {}
+    tracking_memory_context<memory_context> ctx;
+    ::FmgrInfo *flinfo = nullptr;
+    ::FunctionCallInfo fcinfo = nullptr;
+    bool busy = false;
+  };
+
+  // Keeps the frame alive (and marked as busy) for the duration of a call, even if a re-entrant
+  // call replaces it
+  struct busy_scope {
+    explicit busy_scope(std::shared_ptr<call_frame> f) : f(std::move(f)) { this->f->busy = true; }
+    ~busy_scope() { f->busy = false; }
+    std::shared_ptr<call_frame> f;
+  };
+
+  std::shared_ptr<call_frame> frame() {
+    if (frame_ == nullptr || frame_->ctx.resets() > 0) {
+      auto f = std::make_shared<call_frame>(cache_context_.value_or(memory_context()));
+      auto &ctx = f->ctx.get_memory_context();
+      f->flinfo = ctx.template alloc<::FmgrInfo>();
+      ffi_guard{::fmgr_info_cxt}(oid_, f->flinfo, ctx);
+      f->fcinfo = reinterpret_cast<::FunctionCallInfo>(
+          ctx.template alloc<std::byte>(SizeForFunctionCallInfo(sizeof...(arg_types))));
+      InitFunctionCallInfoData(*f->fcinfo, f->flinfo, sizeof...(arg_types), InvalidOid, nullptr,
+                               nullptr);
+      frame_ = std::move(f);
+    }
+    return frame_;
+  }
+
+  ret_type invoke(::FunctionCallInfo fcinfo, auto &&...args) {
     bool any_nulls = false;
     auto optval = []<std::size_t I>(auto arg) -> ::Datum {
       using nth_type = std::tuple_element_t<I, std::tuple<arg_types...>>;
@@ -450,13 +780,6 @@ template <has_type_traits ret_type, has_type_traits... arg_types> struct functio
       return false;
     };
     return [&]<std::size_t... I>(std::index_sequence<I...>) -> ret_type {
-      LOCAL_FCINFO(fcinfo, sizeof...(args));
-      ::FmgrInfo flinfo;
-
-      ffi_guard{::fmgr_info}(oid_, &flinfo);
-
-      InitFunctionCallInfoData(*fcinfo, &flinfo, sizeof...(args), InvalidOid, nullptr, nullptr);
-
       ((fcinfo->args[I].value = optval.template operator()<I>(args)), ...);
       ((fcinfo->args[I].isnull = isnull(args)), ...);
 
@@ -468,6 +791,7 @@ template <has_type_traits ret_type, has_type_traits... arg_types> struct functio
         }
       }
 
+      fcinfo->isnull = false;
       nullable_datum result(ffi_guard{[&fcinfo]() { return FunctionCallInvoke(fcinfo); }}());
       if (fcinfo->isnull) {
         result = nullable_datum();
@@ -477,12 +801,11 @@ template <has_type_traits ret_type, has_type_traits... arg_types> struct functio
     }(std::make_index_sequence<sizeof...(args)>{});
   }
 
-  const oid &function_oid() const { return oid_; }
-
-private:
   oid oid_;
   oid rettype_;
   bool strict_;
+  std::optional<memory_context> cache_context_;
+  std::shared_ptr<call_frame> frame_;
 };
 
 template <has_type_traits ret, has_type_traits... Args>
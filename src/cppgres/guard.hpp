@@ -17,6 +17,13 @@ extern "C" {
 
 namespace cppgres {
 
+/**
+ * @brief Calls a Postgres function, converting errors it raises into @ref cppgres::pg_exception
+ *
+ * Establishes its own error handler for the duration of the call, the same way `PG_TRY` does:
+ * no allocations are made and the signal mask is not saved, as Postgres doesn't rely on it being
+ * restored when recovering from an error.
+ */
 template <typename Func> struct ffi_guard {
   Func func;
 
@@ -24,30 +31,71 @@ template <typename Func> struct ffi_guard {
 
   template <typename... Args>
   auto operator()(Args &&...args) -> decltype(func(std::forward<Args>(args)...)) {
-    int state;
-    sigjmp_buf *pbuf;
-    ::ErrorContextCallback *cb;
     sigjmp_buf buf;
     ::MemoryContext mcxt = ::CurrentMemoryContext;
 
-    pbuf = ::PG_exception_stack;
-    cb = ::error_context_stack;
-    ::PG_exception_stack = &buf;
-
     // restore state upon exit
-    std::shared_ptr<void> defer(nullptr, [&](...) {
+    handler_scope scope(&buf);
+
+    if (sigsetjmp(buf, 0) == 0) {
+      return func(std::forward<Args>(args)...);
+    }
+    throw pg_exception(mcxt);
+  }
+
+private:
+  struct handler_scope {
+    explicit handler_scope(sigjmp_buf *buf) noexcept
+        : pbuf(::PG_exception_stack), cb(::error_context_stack) {
+      ::PG_exception_stack = buf;
+    }
+    ~handler_scope() {
       ::error_context_stack = cb;
       ::PG_exception_stack = pbuf;
-    });
+    }
 
-    state = sigsetjmp(buf, 1);
+    handler_scope(const handler_scope &) = delete;
+    handler_scope &operator=(const handler_scope &) = delete;
 
-    if (state == 0) {
-      return func(std::forward<Args>(args)...);
-    } else if (state == 1) {
-      throw pg_exception(mcxt);
-    }
-    __builtin_unreachable();
+    sigjmp_buf *pbuf;
+    ::ErrorContextCallback *cb;
+  };
+};
+
+/**
+ * @brief Runs a batch of Postgres calls under a single @ref cppgres::ffi_guard
+ *
+ * Postgres functions can be called directly (without wrapping each of them into
+ * @ref cppgres::ffi_guard) inside of the region, sharing one error handler. If any of them
+ * raises an error, the region is left and @ref cppgres::pg_exception is thrown.
+ *
+ * @note Same as with `PG_TRY`, the error bypasses C++ unwinding inside of the region, so the
+ *       callable must not create objects with non-trivial destructors, or throw C++ exceptions
+ *       past Postgres frames.
+ *
+ * @param f callable to run
+ * @return whatever the callable returns
+ */
+template <typename Func> decltype(auto) ffi_guard_region(Func &&f) {
+  return ffi_guard{std::forward<Func>(f)}();
+}
+
+/**
+ * @brief Calls a Postgres function that is known to never raise an error, without a guard
+ *
+ * Has the same interface as @ref cppgres::ffi_guard so that it can be swapped in for functions
+ * that don't `ereport` (for example, plain accessors) on hot paths.
+ *
+ * @note Using it with a function that may raise an error will make the error skip C++ frames.
+ */
+template <typename Func> struct ffi_unguarded {
+  Func func;
+
+  explicit ffi_unguarded(Func f) : func(std::move(f)) {}
+
+  template <typename... Args>
+  auto operator()(Args &&...args) -> decltype(func(std::forward<Args>(args)...)) {
+    return func(std::forward<Args>(args)...);
   }
 };
 
@@ -0,0 +1,169 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datum.hpp"
+#include "imports.h"
+#include "memory.hpp"
+#include "type.hpp"
+#include "types.hpp"
+
+extern "C" {
+#include <utils/inet.h>
+}
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+namespace cppgres {
+
+enum class inet_family { ipv4, ipv6 };
+
+/**
+ * @brief Postgres `inet` (host address with an optional netmask)
+ *
+ * Values are read in place, including values with a short varlena header.
+ */
+struct inet : public varlena {
+  using varlena::varlena;
+
+  /**
+   * @brief Makes a new value allocated in `ctx`
+   *
+   * @param family address family
+   * @param address address bytes (4 for IPv4, 16 for IPv6), in network byte order
+   * @param bits netmask length
+   *
+   * @throws std::invalid_argument if the address size or the netmask length don't match the
+   *         address family
+   */
+  inet(inet_family family, std::span<const std::byte> address, int bits,
+       memory_context ctx = memory_context())
+      : varlena(make(family, address, bits, ctx), ctx) {}
+
+  inet_family family() {
+    return data().family == PGSQL_AF_INET ? inet_family::ipv4 : inet_family::ipv6;
+  }
+
+  /**
+   * @brief Netmask length
+   */
+  int bits() { return data().bits; }
+
+  /**
+   * @brief Address bytes, in network byte order
+   */
+  std::span<const std::byte> address() {
+    auto &d = data();
+    return {reinterpret_cast<const std::byte *>(d.ipaddr), d.family == PGSQL_AF_INET ? 4u : 16u};
+  }
+
+  /**
+   * @brief Whether the network of this value contains or equals the network of `other` (like
+   * Postgres' `>>=`)
+   */
+  bool contains(inet &other) {
+    auto &a = data();
+    auto &b = other.data();
+    if (a.family != b.family || a.bits > b.bits) {
+      return false;
+    }
+    int whole = a.bits / 8;
+    if (std::memcmp(a.ipaddr, b.ipaddr, whole) != 0) {
+      return false;
+    }
+    if (auto rest = a.bits % 8; rest != 0) {
+      auto mask = static_cast<unsigned char>(0xFF << (8 - rest));
+      return (a.ipaddr[whole] & mask) == (b.ipaddr[whole] & mask);
+    }
+    return true;
+  }
+
+protected:
+  const ::inet_struct &data() {
+    // The structure is byte-aligned, so values with a short header don't need to be copied
+    return *reinterpret_cast<const ::inet_struct *>(VARDATA_ANY(readable_ptr()));
+  }
+
+  static datum make(inet_family family, std::span<const std::byte> address, int bits,
+                    memory_context &ctx) {
+    std::size_t size = family == inet_family::ipv4 ? 4 : 16;
+    if (address.size() != size) {
+      throw std::invalid_argument(
+          cppgres::fmt::format("expected an address of {} bytes, got {}", size, address.size()));
+    }
+    if (bits < 0 || static_cast<std::size_t>(bits) > size * 8) {
+      throw std::invalid_argument(cppgres::fmt::format("invalid netmask length {}", bits));
+    }
+    auto *v = reinterpret_cast<::inet *>(ctx.alloc<std::byte>(sizeof(::inet)));
+    std::memset(v, 0, sizeof(::inet));
+    auto *d = reinterpret_cast<::inet_struct *>(VARDATA(v));
+    d->family = family == inet_family::ipv4 ? PGSQL_AF_INET : PGSQL_AF_INET6;
+    d->bits = static_cast<unsigned char>(bits);
+    std::memcpy(d->ipaddr, address.data(), size);
+    SET_INET_VARSIZE(v);
+    return datum(PointerGetDatum(v));
+  }
+};
+
+/**
+ * @brief Postgres `cidr` (network address)
+ */
+struct cidr : public inet {
+  using inet::inet;
+
+  /**
+   * @brief Makes a new value allocated in `ctx`
+   *
+   * @throws std::invalid_argument if the address has bits set to the right of the netmask
+   *
+   * @see inet::inet(inet_family, std::span<const std::byte>, int, memory_context)
+   */
+  cidr(inet_family family, std::span<const std::byte> address, int bits,
+       memory_context ctx = memory_context())
+      : inet(family, address, bits, ctx) {
+    for (std::size_t i = 0; i < address.size(); i++) {
+      int keep = std::clamp(bits - static_cast<int>(i) * 8, 0, 8);
+      auto mask = static_cast<std::byte>(keep == 0 ? 0 : 0xFF << (8 - keep));
+      if ((address[i] & ~mask) != std::byte{0}) {
+        throw std::invalid_argument("cidr value has bits set to right of mask");
+      }
+    }
+  }
+};
+
+template <> struct type_traits<inet> {
+  type_traits() {}
+  type_traits(const inet &) {}
+  bool is(const type &t) { return t.oid == INETOID || t.oid == CIDROID; }
+  constexpr type type_for() { return type{.oid = INETOID}; }
+};
+
+template <> struct type_traits<cidr> {
+  type_traits() {}
+  type_traits(const cidr &) {}
+  bool is(const type &t) { return t.oid == CIDROID; }
+  constexpr type type_for() { return type{.oid = CIDROID}; }
+};
+
+template <> struct datum_conversion<inet> : default_datum_conversion<inet> {
+  static inet from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return inet{d, ctx};
+  }
+
+  static datum into_datum(const inet &t) { return t.get_datum(); }
+};
+
+template <> struct datum_conversion<cidr> : default_datum_conversion<cidr> {
+  static cidr from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return cidr{d, ctx};
+  }
+
+  static datum into_datum(const cidr &t) { return t.get_datum(); }
+};
+
+} // namespace cppgres
@@ -0,0 +1,542 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datum.hpp"
+#include "imports.h"
+#include "memory.hpp"
+#include "numeric.hpp"
+#include "type.hpp"
+#include "types.hpp"
+#include "utils/utils.hpp"
+
+extern "C" {
+#include <utils/jsonb.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace cppgres {
+
+enum class jsonb_type { null, string, numeric, boolean, array, object };
+
+/**
+ * @brief Read-only view of a value inside of a @ref cppgres::jsonb
+ *
+ * Values are read from jsonb's binary representation (`JsonbContainer`) in place: looking up
+ * object members (with a binary search over their sorted keys), indexing and iterating arrays and
+ * reading scalars don't allocate memory.
+ *
+ * @note Views are only valid as long as the jsonb value they were obtained from.
+ */
+struct jsonb_value {
+  template <bool Members> struct range;
+
+  jsonb_type type() const { return kind; }
+
+  bool is_null() const { return kind == jsonb_type::null; }
+  bool is_object() const { return kind == jsonb_type::object; }
+  bool is_array() const { return kind == jsonb_type::array; }
+
+  /**
+   * @brief String value, `std::nullopt` if the value is not a string
+   */
+  std::optional<std::string_view> as_string() const {
+    if (kind != jsonb_type::string) {
+      return std::nullopt;
+    }
+    return std::string_view(reinterpret_cast<const char *>(data), length);
+  }
+
+  /**
+   * @brief Numeric value, `std::nullopt` if the value is not a number
+   */
+  std::optional<numeric> as_numeric() const {
+    if (kind != jsonb_type::numeric) {
+      return std::nullopt;
+    }
+    return numeric(datum(PointerGetDatum(data)), ctx);
+  }
+
+  /**
+   * @brief Boolean value, `std::nullopt` if the value is not a boolean
+   */
+  std::optional<bool> as_bool() const {
+    if (kind != jsonb_type::boolean) {
+      return std::nullopt;
+    }
+    return length != 0;
+  }
+
+  /**
+   * @brief Number of elements of an array or members of an object, zero for scalars
+   */
+  std::size_t size() const {
+    return is_object() || is_array() ? read32(data) & JB_CMASK : 0;
+  }
+
+  /**
+   * @brief Member of an object, `std::nullopt` if there is none or the value is not an object
+   */
+  std::optional<jsonb_value> get(std::string_view key) const {
+    if (!is_object()) {
+      return std::nullopt;
+    }
+    // Keys are sorted by length first, and then bytewise
+    auto count = static_cast<int>(size());
+    int low = 0, high = count;
+    while (low < high) {
+      int middle = low + (high - low) / 2;
+      auto candidate = *child(middle, offset(middle)).as_string();
+      int cmp = candidate.size() == key.size()
+                    ? (key.empty() ? 0 : std::memcmp(candidate.data(), key.data(), key.size()))
+                    : (candidate.size() < key.size() ? -1 : 1);
+      if (cmp == 0) {
+        return child(middle + count, offset(middle + count));
+      } else if (cmp < 0) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Element of an array, `std::nullopt` if it is out of bounds or the value is not an array
+   */
+  std::optional<jsonb_value> get(std::size_t i) const {
+    if (!is_array() || i >= size()) {
+      return std::nullopt;
+    }
+    return child(static_cast<int>(i), offset(static_cast<int>(i)));
+  }
+
+  /**
+   * @brief Member of an object
+   *
+   * @throws std::out_of_range if there is no such member or the value is not an object
+   */
+  jsonb_value operator[](std::string_view key) const {
+    if (auto v = get(key); v.has_value()) {
+      return *v;
+    }
+    throw std::out_of_range(cppgres::fmt::format("no jsonb member `{}`", key));
+  }
+
+  /**
+   * @brief Element of an array
+   *
+   * @throws std::out_of_range if it is out of bounds or the value is not an array
+   */
+  jsonb_value operator[](std::size_t i) const {
+    if (auto v = get(i); v.has_value()) {
+      return *v;
+    }
+    throw std::out_of_range("jsonb array index out of range");
+  }
+
+  /**
+   * @brief Elements of an array (empty if the value is not an array)
+   */
+  range<false> elements() const;
+
+  /**
+   * @brief Members of an object as key and value pairs, in the order of their keys (empty if the
+   * value is not an object)
+   */
+  range<true> members() const;
+
+private:
+  friend struct jsonb;
+
+  jsonb_value(jsonb_type kind, const std::byte *data, uint32_t length, memory_context ctx)
+      : kind(kind), data(data), length(length), ctx(std::move(ctx)) {}
+
+  // Containers may be unaligned (values with a short varlena header are read in place)
+  static uint32_t read32(const std::byte *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static jsonb_value container(const std::byte *data, uint32_t length, memory_context ctx) {
+    auto header = read32(data);
+    return jsonb_value(header & JB_FOBJECT ? jsonb_type::object : jsonb_type::array, data,
+                       length, std::move(ctx));
+  }
+
+  int entries() const {
+    auto count = static_cast<int>(size());
+    return is_object() ? count * 2 : count;
+  }
+
+  JEntry entry(int i) const { return read32(data + sizeof(uint32_t) + i * sizeof(JEntry)); }
+
+  // Entries store either their length or, every few entries, their end offset
+  uint32_t offset(int i) const {
+    uint32_t off = 0;
+    for (int j = i - 1; j >= 0; j--) {
+      auto e = entry(j);
+      off += JBE_OFFLENFLD(e);
+      if (JBE_HAS_OFF(e)) {
+        break;
+      }
+    }
+    return off;
+  }
+
+  uint32_t next_offset(int i, uint32_t off) const {
+    auto e = entry(i);
+    return JBE_HAS_OFF(e) ? JBE_OFFLENFLD(e) : off + JBE_OFFLENFLD(e);
+  }
+
+  jsonb_value child(int i, uint32_t off) const {
+    auto e = entry(i);
+    auto len = next_offset(i, off) - off;
+    auto *base = data + sizeof(uint32_t) + entries() * sizeof(JEntry);
+    if (JBE_ISSTRING(e)) {
+      return jsonb_value(jsonb_type::string, base + off, len, ctx);
+    } else if (JBE_ISNUMERIC(e) || JBE_ISCONTAINER(e)) {
+      // Numbers and containers are aligned (relative to the start of the container)
+      auto padding = INTALIGN(off) - off;
+      if (JBE_ISNUMERIC(e)) {
+        return jsonb_value(jsonb_type::numeric, base + off + padding, len - padding, ctx);
+      }
+      return container(base + off + padding, len - padding, ctx);
+    } else if (JBE_ISNULL(e)) {
+      return jsonb_value(jsonb_type::null, nullptr, 0, ctx);
+    }
+    return jsonb_value(jsonb_type::boolean, nullptr, JBE_ISBOOL_TRUE(e) ? 1 : 0, ctx);
+  }
+
+  jsonb_type kind;
+  const std::byte *data;
+  uint32_t length;
+  memory_context ctx;
+};
+
+/**
+ * @brief Elements of an array or members (key and value pairs) of an object
+ */
+template <bool Members> struct jsonb_value::range {
+  struct iterator {
+    using iterator_category = std::input_iterator_tag;
+    using value_type =
+        std::conditional_t<Members, std::pair<std::string_view, jsonb_value>, jsonb_value>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() noexcept : i(0), n(0) {}
+    // The value is copied so that iterators outlive the range they were obtained from
+    iterator(std::optional<jsonb_value> v, int i, int n) : v(std::move(v)), i(i), n(n) {
+      if (this->v.has_value() && i == 0 && i < n) {
+        off = 0;
+        if constexpr (Members) {
+          value_off = this->v->offset(n);
+        }
+      }
+    }
+
+    value_type operator*() const {
+      if constexpr (Members) {
+        return {*v->child(i, off).as_string(), v->child(i + n, value_off)};
+      } else {
+        return v->child(i, off);
+      }
+    }
+
+    // Offsets are carried over from one entry to the next, so iterating is linear
+    iterator &operator++() {
+      off = v->next_offset(i, off);
+      if constexpr (Members) {
+        value_off = v->next_offset(i + n, value_off);
+      }
+      i++;
+      return *this;
+    }
+    iterator operator++(int) {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+
+    bool operator==(const iterator &other) const { return i == other.i; }
+
+  private:
+    std::optional<jsonb_value> v;
+    int i;
+    int n;
+    uint32_t off = 0;
+    uint32_t value_off = 0;
+  };
+
+  iterator begin() const { return iterator(v, 0, n); }
+  iterator end() const { return iterator(std::nullopt, n, n); }
+
+private:
+  friend struct jsonb_value;
+  range(jsonb_value v, bool valid) : v(std::move(v)), n(valid ? static_cast<int>(this->v.size())
+                                                               : 0) {}
+
+  jsonb_value v;
+  int n;
+};
+
+inline jsonb_value::range<false> jsonb_value::elements() const { return {*this, is_array()}; }
+inline jsonb_value::range<true> jsonb_value::members() const { return {*this, is_object()}; }
+
+/**
+ * @brief Postgres `jsonb`
+ *
+ * Compressed or out-of-line values are detoasted once; other values (including ones with a short
+ * varlena header) are read in place.
+ *
+ * @see jsonb_value
+ */
+struct jsonb : public varlena {
+  using varlena::varlena;
+
+  /**
+   * @brief Top-level value
+   */
+  jsonb_value root() {
+    auto *v = readable_ptr();
+    auto top = jsonb_value::container(reinterpret_cast<const std::byte *>(VARDATA_ANY(v)),
+                                      VARSIZE_ANY_EXHDR(v), ctx);
+    // Top-level scalars are stored as single-element arrays
+    if (jsonb_value::read32(top.data) & JB_FSCALAR) {
+      return top.child(0, 0);
+    }
+    return top;
+  }
+
+  /**
+   * @brief Member of the top-level object
+   *
+   * @see jsonb_value::get(std::string_view)
+   */
+  std::optional<jsonb_value> get(std::string_view key) { return root().get(key); }
+
+  /**
+   * @brief Element of the top-level array
+   *
+   * @see jsonb_value::get(std::size_t)
+   */
+  std::optional<jsonb_value> get(std::size_t i) { return root().get(i); }
+};
+
+/**
+ * @brief Ranges of key and value pairs encoded as jsonb objects
+ */
+template <typename T>
+concept jsonb_object_range =
+    std::ranges::input_range<const T> && requires(std::ranges::range_value_t<const T> p) {
+      { p.first } -> std::convertible_to<std::string_view>;
+      p.second;
+    };
+
+/**
+ * @brief Builds @ref cppgres::jsonb values out of C++ values
+ *
+ * Values are laid out as a tree of `JsonbValue` nodes in a scratch memory context and encoded
+ * into jsonb's binary format once, without producing or parsing JSON text. The scratch memory
+ * context is reset for every value built, so a builder can be reused to build many values at the
+ * cost of a single encoding each.
+ *
+ * Values are encoded as follows:
+ *
+ * - `std::nullopt`, empty `std::optional` and `nullptr` as `null`
+ * - `bool` as a boolean
+ * - integers, @ref cppgres::numeric and finite floating point numbers as numbers (`NaN` and
+ *   infinite values as strings, like `to_jsonb` does)
+ * - values convertible to `std::string_view` as strings
+ * - ranges of key and value pairs (such as `std::map`) as objects (the last of the duplicate keys
+ *   wins)
+ * - other ranges as arrays
+ * - other aggregates (when their field names can be reflected) as objects
+ *
+ * @note Strings are expected to be valid in the database encoding; they are not validated.
+ */
+struct jsonb_builder {
+  jsonb_builder() = default;
+  jsonb_builder(const jsonb_builder &) = delete;
+  jsonb_builder &operator=(const jsonb_builder &) = delete;
+
+  /**
+   * @brief Builds a jsonb value out of `value`, allocating it in `ctx`
+   */
+  template <typename T> jsonb build(const T &value, memory_context ctx = memory_context()) {
+    scratch.reset();
+    ::JsonbValue root;
+    scratch([&]() { encode<false>(root, value); });
+    memory_context_scope scope(ctx);
+    auto *j = ffi_guard{::JsonbValueToJsonb}(&root);
+    return jsonb(datum(PointerGetDatum(j)), ctx);
+  }
+
+private:
+  // Values of ranges that don't produce references are temporaries, so their strings are copied
+  template <bool Copy, typename T> void encode(::JsonbValue &out, const T &v) {
+    using U = std::remove_cvref_t<T>;
+    if constexpr (std::same_as<U, std::nullptr_t> || std::same_as<U, std::nullopt_t>) {
+      out.type = jbvNull;
+    } else if constexpr (utils::is_optional<U>) {
+      if (v.has_value()) {
+        encode<Copy>(out, *v);
+      } else {
+        out.type = jbvNull;
+      }
+    } else if constexpr (std::same_as<U, bool>) {
+      out.type = jbvBool;
+      out.val.boolean = v;
+    } else if constexpr (std::same_as<U, numeric>) {
+      numeric n = v;
+      if (n.is_nan()) {
+        string<false>(out, "NaN");
+      } else if (n.is_infinite()) {
+        string<false>(out, n.is_negative() ? "-Infinity" : "Infinity");
+      } else {
+        // Numbers are stored with a regular varlena header
+        out.type = jbvNumeric;
+        out.val.numeric = reinterpret_cast<::Numeric>(ffi_guard{::pg_detoast_datum}(
+            reinterpret_cast<::varlena *>(DatumGetPointer(n.get_datum()))));
+      }
+    } else if constexpr (numeric_fixed_point_rep<U> && sizeof(U) > sizeof(int64_t)) {
+      encode<Copy>(out, numeric::from_integer(v));
+    } else if constexpr (std::integral<U> && sizeof(U) <= sizeof(int64_t)) {
+      // Unsigned and 8-bit integers are widened into a representation numeric converts from
+      using wide = std::conditional_t<std::unsigned_integral<U> && sizeof(U) == sizeof(int64_t),
+                                      __int128, int64_t>;
+      encode<Copy>(out, numeric::from_integer(static_cast<wide>(v)));
+    } else if constexpr (std::floating_point<U>) {
+      if (std::isnan(v)) {
+        string<false>(out, "NaN");
+      } else if (std::isinf(v)) {
+        string<false>(out, v < 0 ? "-Infinity" : "Infinity");
+      } else {
+        encode<Copy>(out, numeric::from_double(static_cast<double>(v)));
+      }
+    } else if constexpr (std::convertible_to<const U &, std::string_view>) {
+      string<Copy>(out, std::string_view(v));
+    } else if constexpr (jsonb_object_range<U>) {
+      constexpr bool copy = Copy || !std::is_reference_v<std::ranges::range_reference_t<const U>>;
+      auto [pairs, n] = collect<::JsonbPair>(v, [&](::JsonbPair &pair, auto &&p) {
+        string<copy>(pair.key, std::string_view(p.first));
+        encode<copy>(pair.value, p.second);
+      });
+      object(out, pairs, n);
+    } else if constexpr (std::ranges::input_range<const U>) {
+      constexpr bool copy = Copy || !std::is_reference_v<std::ranges::range_reference_t<const U>>;
+      auto [elems, n] = collect<::JsonbValue>(
+          v, [&](::JsonbValue &elem, auto &&e) { encode<copy>(elem, e); });
+      out.type = jbvArray;
+      out.val.array.nElems = static_cast<int>(n);
+      out.val.array.elems = elems;
+      out.val.array.rawScalar = false;
+#if BOOST_PFR_CORE_NAME_ENABLED
+    } else if constexpr (std::is_aggregate_v<U>) {
+      constexpr auto names = boost::pfr::names_as_array<U>();
+      constexpr std::size_t n = names.size();
+      auto *pairs = scratch.alloc<::JsonbPair>(std::max<std::size_t>(n, 1));
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((string<false>(pairs[I].key, names[I]),
+          encode<Copy>(pairs[I].value, boost::pfr::get<I>(v))),
+         ...);
+      }(std::make_index_sequence<n>{});
+      object(out, pairs, n);
+#endif
+    } else {
+      static_assert(sizeof(U) == 0, "type can't be encoded as jsonb");
+    }
+  }
+
+  template <bool Copy> void string(::JsonbValue &out, std::string_view s) {
+    if (s.size() > JENTRY_OFFLENMASK) {
+      throw std::length_error("string too long to be represented as a jsonb string");
+    }
+    char *data = const_cast<char *>(s.data());
+    if constexpr (Copy) {
+      data = scratch.alloc<char>(std::max<std::size_t>(s.size(), 1));
+      std::memcpy(data, s.data(), s.size());
+    }
+    out.type = jbvString;
+    out.val.string.len = static_cast<int>(s.size());
+    out.val.string.val = data;
+  }
+
+  // Collects the elements of a range into an array, growing it geometrically unless the range
+  // is sized
+  template <typename E, typename R, typename F>
+  std::pair<E *, std::size_t> collect(const R &r, F f) {
+    std::size_t cap = 8;
+    if constexpr (std::ranges::sized_range<const R>) {
+      cap = std::max<std::size_t>(std::ranges::size(r), 1);
+    }
+    auto *items = scratch.alloc<E>(cap);
+    std::size_t n = 0;
+    for (auto &&item : r) {
+      if (n == cap) {
+        cap *= 2;
+        items = static_cast<E *>(ffi_guard{::repalloc}(items, cap * sizeof(E)));
+      }
+      f(items[n], item);
+      n++;
+    }
+    return {items, n};
+  }
+
+  // Object members must be sorted the way jsonb sorts keys (by length first, and then bytewise)
+  // and unique
+  static void object(::JsonbValue &out, ::JsonbPair *pairs, std::size_t n) {
+    auto key = [](const ::JsonbPair &p) {
+      return std::string_view(p.key.val.string.val, p.key.val.string.len);
+    };
+    auto less = [&](const ::JsonbPair &a, const ::JsonbPair &b) {
+      auto ka = key(a), kb = key(b);
+      return ka.size() != kb.size() ? ka.size() < kb.size() : ka < kb;
+    };
+    std::stable_sort(pairs, pairs + n, less);
+    std::size_t unique = 0;
+    for (std::size_t i = 0; i < n; i++) {
+      // Of the pairs with the same key, the last one wins
+      if (i + 1 < n && key(pairs[i]) == key(pairs[i + 1])) {
+        continue;
+      }
+      pairs[unique++] = pairs[i];
+    }
+    out.type = jbvObject;
+    out.val.object.nPairs = static_cast<int>(unique);
+    out.val.object.pairs = pairs;
+  }
+
+  alloc_set_memory_context scratch;
+};
+
+template <> struct type_traits<jsonb> {
+  type_traits() {}
+  type_traits(const jsonb &) {}
+  bool is(const type &t) { return t.oid == JSONBOID; }
+  constexpr type type_for() { return type{.oid = JSONBOID}; }
+};
+
+template <> struct datum_conversion<jsonb> : default_datum_conversion<jsonb> {
+  static jsonb from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return jsonb{d, ctx};
+  }
+
+  static datum into_datum(const jsonb &t) { return t.get_datum(); }
+};
+
+} // namespace cppgres
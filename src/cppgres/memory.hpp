@@ -3,9 +3,15 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <memory_resource>
 #include <type_traits>
+#include <unordered_map>
 
 #include "guard.hpp"
 #include "imports.h"
@@ -269,6 +275,105 @@ protected:
   ::MemoryContext _memory_context() override { return ctx._memory_context(); }
 };
 
+/**
+ * @brief Cheap check whether a memory context has been reset (or deleted) since a point in time
+ *
+ * Unlike @ref tracking_memory_context, this does not allocate for every tracked value. Every
+ * tracked memory context gets a generation counter and one reset callback (allocated in the
+ * context itself), registered the first time the context is tracked after it was created or last
+ * reset. All values tracked in the same context share them.
+ *
+ * When the callback fires, the counter is advanced and recycled for the next context that gets
+ * tracked. Counters only ever advance, so values tracked before stay invalid, and the number of
+ * counters is bounded by the number of contexts tracked at the same time rather than growing with
+ * every context ever tracked.
+ *
+ * `TopMemoryContext` is never reset, so tracking it costs nothing. A default-constructed
+ * generation tracks nothing and is always valid.
+ */
+struct memory_context_generation {
+  memory_context_generation() noexcept = default;
+
+  explicit memory_context_generation(::MemoryContext ctx) {
+    if (ctx == nullptr || ctx == TopMemoryContext) {
+      return;
+    }
+    counter = &counter_for(ctx);
+    generation = counter->generation;
+  }
+
+  /**
+   * @brief Returns true if the memory context has not been reset or deleted since
+   */
+  bool valid() const noexcept { return counter == nullptr || counter->generation == generation; }
+
+private:
+  struct context_counter {
+    uint64_t generation = 0;
+    /**
+     * @brief Context the counter is tracking, `nullptr` while the counter is free
+     */
+    ::MemoryContext context = nullptr;
+    context_counter *next_free = nullptr;
+  };
+
+  static void advance(void *arg) {
+    auto *c = static_cast<context_counter *>(arg);
+    c->generation++;
+    // reset callbacks are discarded once they have been called, so the context gets a new
+    // counter if it is tracked again
+    counters.erase(c->context);
+    if (last_context == c->context) {
+      last_context = nullptr;
+      last_counter = nullptr;
+    }
+    c->context = nullptr;
+    c->next_free = free_counters;
+    free_counters = c;
+  }
+
+  static context_counter &counter_for(::MemoryContext ctx) {
+    if (ctx == last_context) {
+      return *last_counter;
+    }
+    auto it = counters.find(ctx);
+    if (it == counters.end()) {
+      auto *cb = static_cast<::MemoryContextCallback *>(
+          ffi_guard{::MemoryContextAlloc}(ctx, sizeof(::MemoryContextCallback)));
+      context_counter *c = free_counters;
+      if (c != nullptr) {
+        free_counters = c->next_free;
+      } else {
+        // a deque, so counters never move
+        c = &pool.emplace_back();
+      }
+      try {
+        it = counters.emplace(ctx, c).first;
+      } catch (...) {
+        c->next_free = free_counters;
+        free_counters = c;
+        throw;
+      }
+      c->context = ctx;
+      cb->func = advance;
+      cb->arg = c;
+      ffi_guard{::MemoryContextRegisterResetCallback}(ctx, cb);
+    }
+    last_context = ctx;
+    last_counter = it->second;
+    return *last_counter;
+  }
+
+  static inline std::deque<context_counter> pool;
+  static inline context_counter *free_counters = nullptr;
+  static inline std::unordered_map<::MemoryContext, context_counter *> counters;
+  static inline ::MemoryContext last_context = nullptr;
+  static inline context_counter *last_counter = nullptr;
+
+  context_counter *counter = nullptr;
+  uint64_t generation = 0;
+};
+
 template <typename T>
 concept a_memory_context =
     std::derived_from<T, abstract_memory_context> && std::default_initializable<T>;
@@ -323,6 +428,183 @@ private:
   bool explicit_deallocation;
 };
 
+/**
+ * @brief `std::pmr::memory_resource` allocating in a memory context
+ *
+ * Lets `std::pmr` containers live in a memory context, so they are freed wholesale when the
+ * context is reset or deleted (including on error). Like @ref memory_context_allocator,
+ * deallocation is a no-op unless `explicit_deallocation` is set or the context is
+ * `TopMemoryContext`.
+ *
+ * ```c++
+ * cppgres::memory_context_resource resource;
+ * std::pmr::vector<int> v(&resource);
+ * ```
+ *
+ * @note Allocation failures are reported as `std::bad_alloc`.
+ */
+template <a_memory_context Context = memory_context>
+struct memory_context_resource : public std::pmr::memory_resource {
+  explicit memory_context_resource(Context ctx = Context(), bool explicit_deallocation = false)
+      : context(std::move(ctx)), explicit_deallocation(explicit_deallocation) {}
+
+  Context &memory_context() { return context; }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    int flags = MCXT_ALLOC_NO_OOM | (bytes > MaxAllocSize ? MCXT_ALLOC_HUGE : 0);
+    void *ptr;
+    if (alignment <= MAXIMUM_ALIGNOF) {
+      ptr = ffi_guard{::MemoryContextAllocExtended}(context, bytes, flags);
+    } else {
+#if PG_VERSION_NUM >= 160000
+      ptr = ffi_guard{::MemoryContextAllocAligned}(context, bytes, alignment, flags);
+#else
+      // The chunk is over-allocated and its start is kept right before the aligned address (there
+      // is always room for it, as chunks are at least pointer-aligned)
+      void *chunk = ffi_guard{::MemoryContextAllocExtended}(
+          context, bytes + alignment,
+          flags | (bytes + alignment > MaxAllocSize ? MCXT_ALLOC_HUGE : 0));
+      ptr = nullptr;
+      if (chunk != nullptr) {
+        auto address = reinterpret_cast<std::uintptr_t>(chunk) + sizeof(void *);
+        ptr = reinterpret_cast<void *>((address + alignment - 1) & ~(alignment - 1));
+        static_cast<void **>(ptr)[-1] = chunk;
+      }
+#endif
+    }
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+  void do_deallocate(void *p, std::size_t, std::size_t alignment) override {
+    if (explicit_deallocation || context == top_memory_context()) {
+#if PG_VERSION_NUM < 160000
+      // Over-aligned allocations don't point to the start of their chunk
+      if (alignment > MAXIMUM_ALIGNOF) {
+        p = static_cast<void **>(p)[-1];
+      }
+#endif
+      ffi_guard{::pfree}(p);
+    }
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    auto *r = dynamic_cast<const memory_context_resource *>(&other);
+    return r != nullptr && explicit_deallocation == r->explicit_deallocation &&
+           const_cast<Context &>(context) == const_cast<Context &>(r->context);
+  }
+
+private:
+  Context context;
+  bool explicit_deallocation;
+};
+
+/**
+ * @brief Monotonic `std::pmr::memory_resource` that bumps a pointer through large blocks
+ * allocated in a memory context
+ *
+ * Allocating is a pointer increment most of the time; deallocating does nothing. Blocks start at
+ * `initial_block_size` and double up to `max_block_size` (larger requests get a block of their
+ * own). They are freed by @ref release, when the resource is destroyed, or, wholesale, when the
+ * memory context is reset or deleted; the resource notices the reset and starts over with new
+ * blocks.
+ *
+ * ```c++
+ * cppgres::memory_context_bump_resource resource;
+ * std::pmr::unordered_map<int64_t, int64_t> counts(&resource);
+ * ```
+ */
+template <a_memory_context Context = memory_context>
+struct memory_context_bump_resource : public std::pmr::memory_resource {
+  explicit memory_context_bump_resource(Context ctx = Context(),
+                                        std::size_t initial_block_size = ALLOCSET_DEFAULT_INITSIZE,
+                                        std::size_t max_block_size = ALLOCSET_DEFAULT_MAXSIZE)
+      : context(std::move(ctx)), next_block_size(std::max<std::size_t>(initial_block_size, 64)),
+        max_block_size(std::max(max_block_size, next_block_size)) {}
+
+  memory_context_bump_resource(const memory_context_bump_resource &) = delete;
+  memory_context_bump_resource &operator=(const memory_context_bump_resource &) = delete;
+
+  ~memory_context_bump_resource() override { release(); }
+
+  Context &memory_context() { return context; }
+
+  /**
+   * @brief Frees all blocks (unless the memory context already did)
+   */
+  void release() {
+    if (generation.valid()) {
+      while (blocks != nullptr) {
+        auto *next = blocks->next;
+        ffi_guard{::pfree}(blocks);
+        blocks = next;
+      }
+    }
+    blocks = nullptr;
+    current = end = nullptr;
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (!generation.valid()) {
+      // The memory context was reset and the blocks went with it
+      blocks = nullptr;
+      current = end = nullptr;
+    }
+    auto *ptr = align(current, alignment);
+    if (current == nullptr || bytes > static_cast<std::size_t>(end - ptr)) {
+      grow(bytes + alignment);
+      ptr = align(current, alignment);
+    }
+    current = ptr + bytes;
+    return ptr;
+  }
+
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  struct block {
+    block *next;
+  };
+
+  static std::byte *align(std::byte *ptr, std::size_t alignment) {
+    auto address = reinterpret_cast<std::uintptr_t>(ptr);
+    return reinterpret_cast<std::byte *>((address + alignment - 1) & ~(alignment - 1));
+  }
+
+  void grow(std::size_t min_size) {
+    auto size = std::max(next_block_size, min_size + MAXALIGN(sizeof(block)));
+    if (blocks == nullptr) {
+      generation = memory_context_generation(context);
+    }
+    int flags = MCXT_ALLOC_NO_OOM | (size > MaxAllocSize ? MCXT_ALLOC_HUGE : 0);
+    auto *b = static_cast<block *>(ffi_guard{::MemoryContextAllocExtended}(context, size, flags));
+    if (b == nullptr) {
+      throw std::bad_alloc();
+    }
+    b->next = blocks;
+    blocks = b;
+    current = reinterpret_cast<std::byte *>(b) + MAXALIGN(sizeof(block));
+    end = reinterpret_cast<std::byte *>(b) + size;
+    next_block_size = std::min(next_block_size * 2, max_block_size);
+  }
+
+  Context context;
+  std::size_t next_block_size;
+  std::size_t max_block_size;
+  memory_context_generation generation;
+  block *blocks = nullptr;
+  std::byte *current = nullptr;
+  std::byte *end = nullptr;
+};
+
 struct pointer_gone_exception : public std::exception {
   const char *what() const noexcept override {
     return "pointer belongs to a MemoryContext that has been reset or deleted";
@@ -0,0 +1,387 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datum.hpp"
+#include "guard.hpp"
+#include "imports.h"
+#include "memory.hpp"
+#include "type.hpp"
+#include "types.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace cppgres {
+
+/**
+ * @brief Signed integers that can hold fixed-point representations of @ref cppgres::numeric
+ *
+ * Integers narrower than 16 bits aren't included, as they can't hold a base-10000 digit.
+ */
+template <typename T>
+concept numeric_fixed_point_rep =
+    (std::signed_integral<T> && sizeof(T) >= sizeof(int16_t)) || std::same_as<T, __int128>;
+
+/**
+ * @brief Postgres arbitrary precision number (`numeric`)
+ *
+ * Conversions to and from fixed-point integers (`int64_t`, `__int128`, ...) and to `double` read
+ * and write Postgres' base-10000 digit representation directly, without going through text.
+ * Reading a value never allocates memory, unless it is compressed or stored out of line (values
+ * stored in a table with a short header are read as is).
+ *
+ * Arithmetic and comparisons, where precision matters, are performed with Postgres' own numeric
+ * functions, and their results are allocated in the current memory context.
+ */
+struct numeric : public varlena {
+  using varlena::varlena;
+
+  /**
+   * @brief Makes a numeric out of fixed-point `value` with `scale` decimal digits after the
+   * decimal point (`value * 10^-scale`)
+   *
+   * @throws std::invalid_argument if the scale is negative or too large
+   */
+  template <numeric_fixed_point_rep I>
+  static numeric from_scaled(I value, int scale, memory_context ctx = memory_context()) {
+    if (scale < 0 || scale > DSCALE_MASK) {
+      throw std::invalid_argument(cppgres::fmt::format("invalid numeric scale {}", scale));
+    }
+    using U = std::conditional_t<std::same_as<I, __int128>, unsigned __int128, uint64_t>;
+    U mag = value < 0 ? U(0) - static_cast<U>(value) : static_cast<U>(value);
+
+    // Digits, least significant first; the least significant one starts right after the decimal
+    // point (padded with zeros if the scale isn't a multiple of the digit size). Every digit
+    // holds more than 13 bits.
+    constexpr int max_digits = sizeof(U) * CHAR_BIT / 13 + 2;
+    int16_t digits[max_digits];
+    int ndigits = 0;
+    int fraction_digits = (scale + DEC_DIGITS - 1) / DEC_DIGITS;
+    if (auto rem = scale % DEC_DIGITS; rem != 0) {
+      int p = 1;
+      for (int i = 0; i < rem; i++) {
+        p *= 10;
+      }
+      digits[ndigits++] = static_cast<int16_t>((mag % p) * (NBASE / p));
+      mag /= p;
+    }
+    while (mag != 0) {
+      digits[ndigits++] = static_cast<int16_t>(mag % NBASE);
+      mag /= NBASE;
+    }
+    int weight = ndigits - 1 - fraction_digits;
+
+    // Strip trailing and leading zeros, like Postgres does
+    int low = 0;
+    while (low < ndigits && digits[low] == 0) {
+      low++;
+    }
+    while (ndigits > low && digits[ndigits - 1] == 0) {
+      ndigits--;
+      weight--;
+    }
+    ndigits -= low;
+    bool negative = value < 0 && ndigits > 0;
+    if (ndigits == 0) {
+      weight = 0;
+    }
+
+    bool is_short = scale <= SHORT_DSCALE_MAX && weight <= SHORT_WEIGHT_MAX &&
+                    weight >= SHORT_WEIGHT_MIN;
+    std::size_t header = is_short ? sizeof(uint16_t) : sizeof(uint16_t) + sizeof(int16_t);
+    std::size_t size = VARHDRSZ + header + ndigits * sizeof(int16_t);
+    auto *p = ctx.alloc<std::byte>(size);
+    SET_VARSIZE(p, size);
+    auto *data = reinterpret_cast<std::byte *>(VARDATA(p));
+    if (is_short) {
+      auto h = static_cast<uint16_t>((negative ? (SHORT | SHORT_SIGN_MASK) : SHORT) |
+                                     (scale << SHORT_DSCALE_SHIFT) |
+                                     (weight < 0 ? SHORT_WEIGHT_SIGN_MASK : 0) |
+                                     (weight & SHORT_WEIGHT_MASK));
+      std::memcpy(data, &h, sizeof(h));
+    } else {
+      auto sign_dscale = static_cast<uint16_t>((negative ? NEG : POS) | (scale & DSCALE_MASK));
+      int16_t w = static_cast<int16_t>(weight);
+      std::memcpy(data, &sign_dscale, sizeof(sign_dscale));
+      std::memcpy(data + sizeof(sign_dscale), &w, sizeof(w));
+    }
+    auto *out = reinterpret_cast<int16_t *>(data + header);
+    for (int i = 0; i < ndigits; i++) {
+      out[i] = digits[low + ndigits - 1 - i];
+    }
+    return numeric(datum(PointerGetDatum(p)), ctx);
+  }
+
+  /**
+   * @brief Makes a numeric out of an integer
+   */
+  template <numeric_fixed_point_rep I>
+  static numeric from_integer(I value, memory_context ctx = memory_context()) {
+    return from_scaled(value, 0, ctx);
+  }
+
+  /**
+   * @brief Makes a numeric out of a `double`, the way Postgres casts `float8` to `numeric`
+   */
+  static numeric from_double(double value) {
+    return numeric(datum(ffi_guard{[value]() {
+                     return DirectFunctionCall1(::float8_numeric, Float8GetDatum(value));
+                   }}()),
+                   memory_context());
+  }
+
+  bool is_nan() { return (read().flags & EXT_SIGN_MASK) == NAN_FLAGS; }
+
+  bool is_infinite() {
+    auto flags = read().flags & EXT_SIGN_MASK;
+    return flags == PINF || flags == NINF;
+  }
+
+  bool is_negative() {
+    auto v = read();
+    return v.special() ? (v.flags & EXT_SIGN_MASK) == NINF : v.negative;
+  }
+
+  /**
+   * @brief Display scale (number of decimal digits after the decimal point)
+   */
+  int scale() { return read().dscale; }
+
+  /**
+   * @brief Fixed-point representation with `scale` decimal digits after the decimal point
+   * (`value * 10^scale`), rounded half away from zero like Postgres rounds numerics
+   *
+   * @throws std::domain_error if the value is NaN or infinite
+   * @throws std::overflow_error if the value doesn't fit into `I`
+   */
+  template <numeric_fixed_point_rep I> I to_scaled(int scale) {
+    if (scale < 0) {
+      throw std::invalid_argument(cppgres::fmt::format("invalid numeric scale {}", scale));
+    }
+    auto v = read();
+    if (v.special()) {
+      throw std::domain_error("cannot convert NaN or infinity to a fixed-point number");
+    }
+    // Accumulated with the sign of the value, so that the minimum value of `I` fits
+    I acc = 0;
+    auto overflow = [] { throw std::overflow_error("numeric value out of range"); };
+    auto shift = [&](I factor, I digit) {
+      if (__builtin_mul_overflow(acc, factor, &acc) ||
+          (v.negative ? __builtin_sub_overflow(acc, digit, &acc)
+                      : __builtin_add_overflow(acc, digit, &acc))) {
+        overflow();
+      }
+    };
+
+    // Exponent (base 10) of the most significant decimal digit not yet accumulated
+    int e = v.weight * DEC_DIGITS + DEC_DIGITS - 1;
+    int round_digit = 0;
+    bool truncated = false;
+    for (int i = 0; i < v.ndigits && !truncated; i++) {
+      int digit = v.digit(i);
+      if (e - (DEC_DIGITS - 1) >= -scale) {
+        shift(NBASE, digit);
+        e -= DEC_DIGITS;
+        continue;
+      }
+      for (int div = NBASE / 10; div > 0; div /= 10, e--) {
+        if (e < -scale) {
+          // Only the first digit past the scale matters for rounding
+          if (e == -scale - 1) {
+            round_digit = (digit / div) % 10;
+          }
+          truncated = true;
+          break;
+        }
+        shift(10, (digit / div) % 10);
+      }
+    }
+    if (acc != 0 && !truncated) {
+      for (; e >= -scale; e--) {
+        shift(10, 0);
+      }
+    }
+    if (round_digit >= 5) {
+      shift(1, 1);
+    }
+    return acc;
+  }
+
+  /**
+   * @brief Integral value, rounded half away from zero
+   *
+   * @see to_scaled
+   */
+  template <numeric_fixed_point_rep I> I to_integer() { return to_scaled<I>(0); }
+
+  /**
+   * @brief Closest `double`
+   *
+   * Computed from the digits directly, it may differ in the last bit from Postgres' own
+   * conversion (which goes through text).
+   */
+  double to_double() {
+    auto v = read();
+    if (v.special()) {
+      switch (v.flags & EXT_SIGN_MASK) {
+      case PINF:
+        return std::numeric_limits<double>::infinity();
+      case NINF:
+        return -std::numeric_limits<double>::infinity();
+      default:
+        return std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+    // Digits past the precision of a double (17 to 20 significant decimal digits are used) don't
+    // change the result, and accumulating all of them would overflow for long values
+    int ndigits = std::min(v.ndigits, 5);
+    double result = 0;
+    for (int i = 0; i < ndigits; i++) {
+      result = result * NBASE + v.digit(i);
+    }
+    // Dividing by an exact power of ten (rather than multiplying by an inexact negative one)
+    // keeps values with a few fractional digits correctly rounded
+    auto scale = [&result](int exponent) {
+      result =
+          exponent < 0 ? result / std::pow(10.0, -exponent) : result * std::pow(10.0, exponent);
+    };
+    int exponent = (v.weight - ndigits + 1) * DEC_DIGITS;
+    if (std::abs(exponent) > std::numeric_limits<double>::max_exponent10 - 20) {
+      // Close to the limits of double (subnormal values included), the power of ten itself
+      // would be out of range, so the value is scaled in two steps
+      scale(exponent / 2);
+      scale(exponent - exponent / 2);
+    } else {
+      scale(exponent);
+    }
+    return v.negative ? -result : result;
+  }
+
+  friend numeric operator+(const numeric &a, const numeric &b) { return call(::numeric_add, a, b); }
+  friend numeric operator-(const numeric &a, const numeric &b) { return call(::numeric_sub, a, b); }
+  friend numeric operator*(const numeric &a, const numeric &b) { return call(::numeric_mul, a, b); }
+  friend numeric operator/(const numeric &a, const numeric &b) { return call(::numeric_div, a, b); }
+
+  /**
+   * @brief Compares values like Postgres does (NaN is equal to itself and greater than any other
+   * value)
+   */
+  friend std::strong_ordering operator<=>(const numeric &a, const numeric &b) {
+    auto cmp = DatumGetInt32(call_datum(::numeric_cmp, a, b));
+    return cmp < 0 ? std::strong_ordering::less
+                   : (cmp > 0 ? std::strong_ordering::greater : std::strong_ordering::equal);
+  }
+
+  friend bool operator==(const numeric &a, const numeric &b) {
+    return (a <=> b) == std::strong_ordering::equal;
+  }
+
+private:
+  // On-disk representation (see `src/backend/utils/adt/numeric.c`)
+  static constexpr int NBASE = 10000;
+  static constexpr int DEC_DIGITS = 4;
+  static constexpr uint16_t SIGN_MASK = 0xC000;
+  static constexpr uint16_t POS = 0x0000;
+  static constexpr uint16_t NEG = 0x4000;
+  static constexpr uint16_t SHORT = 0x8000;
+  static constexpr uint16_t SPECIAL = 0xC000;
+  static constexpr uint16_t EXT_SIGN_MASK = 0xF000;
+  static constexpr uint16_t NAN_FLAGS = 0xC000;
+  static constexpr uint16_t PINF = 0xD000;
+  static constexpr uint16_t NINF = 0xF000;
+  static constexpr uint16_t DSCALE_MASK = 0x3FFF;
+  static constexpr uint16_t SHORT_SIGN_MASK = 0x2000;
+  static constexpr uint16_t SHORT_DSCALE_MASK = 0x1F80;
+  static constexpr int SHORT_DSCALE_SHIFT = 7;
+  static constexpr int SHORT_DSCALE_MAX = SHORT_DSCALE_MASK >> SHORT_DSCALE_SHIFT;
+  static constexpr uint16_t SHORT_WEIGHT_SIGN_MASK = 0x0040;
+  static constexpr uint16_t SHORT_WEIGHT_MASK = 0x003F;
+  static constexpr int SHORT_WEIGHT_MAX = SHORT_WEIGHT_MASK;
+  static constexpr int SHORT_WEIGHT_MIN = -(SHORT_WEIGHT_MASK + 1);
+
+  struct digits_view {
+    uint16_t flags;
+    bool negative;
+    int weight;
+    int dscale;
+    const std::byte *digits;
+    int ndigits;
+
+    bool special() const { return (flags & SIGN_MASK) == SPECIAL; }
+
+    // Digits may be unaligned in values with a short varlena header
+    int digit(int i) const {
+      int16_t d;
+      std::memcpy(&d, digits + i * sizeof(int16_t), sizeof(d));
+      return d;
+    }
+  };
+
+  digits_view read() {
+    auto *v = readable_ptr();
+    auto *data = reinterpret_cast<const std::byte *>(VARDATA_ANY(v));
+    auto size = VARSIZE_ANY_EXHDR(v);
+    uint16_t h;
+    std::memcpy(&h, data, sizeof(h));
+    digits_view view{.flags = h, .negative = false, .weight = 0, .dscale = 0};
+    std::size_t header;
+    if ((h & SIGN_MASK) == SHORT) {
+      header = sizeof(uint16_t);
+      view.negative = (h & SHORT_SIGN_MASK) != 0;
+      view.dscale = (h & SHORT_DSCALE_MASK) >> SHORT_DSCALE_SHIFT;
+      view.weight = (h & SHORT_WEIGHT_SIGN_MASK ? ~int(SHORT_WEIGHT_MASK) : 0) |
+                    (h & SHORT_WEIGHT_MASK);
+    } else if ((h & SIGN_MASK) == SPECIAL) {
+      header = sizeof(uint16_t);
+    } else {
+      header = sizeof(uint16_t) + sizeof(int16_t);
+      int16_t w;
+      std::memcpy(&w, data + sizeof(uint16_t), sizeof(w));
+      view.negative = (h & SIGN_MASK) == NEG;
+      view.dscale = h & DSCALE_MASK;
+      view.weight = w;
+    }
+    view.digits = data + header;
+    view.ndigits = view.special() ? 0 : static_cast<int>((size - header) / sizeof(int16_t));
+    return view;
+  }
+
+  static ::Datum call_datum(::PGFunction f, const numeric &a, const numeric &b) {
+    return ffi_guard{[&]() {
+      return DirectFunctionCall2(f, a.get_datum().operator const ::Datum &(),
+                                 b.get_datum().operator const ::Datum &());
+    }}();
+  }
+
+  static numeric call(::PGFunction f, const numeric &a, const numeric &b) {
+    return numeric(datum(call_datum(f, a, b)), memory_context());
+  }
+};
+
+template <> struct type_traits<numeric> {
+  type_traits() {}
+  type_traits(const numeric &) {}
+  bool is(const type &t) { return t.oid == NUMERICOID; }
+  constexpr type type_for() { return type{.oid = NUMERICOID}; }
+};
+
+template <> struct datum_conversion<numeric> : default_datum_conversion<numeric> {
+  static numeric from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return numeric{d, ctx};
+  }
+
+  static datum into_datum(const numeric &t) { return t.get_datum(); }
+};
+
+} // namespace cppgres
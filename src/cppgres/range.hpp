@@ -0,0 +1,442 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datetime.hpp"
+#include "datum.hpp"
+#include "guard.hpp"
+#include "imports.h"
+#include "memory.hpp"
+#include "numeric.hpp"
+#include "type.hpp"
+#include "types.hpp"
+
+extern "C" {
+#include <utils/rangetypes.h>
+#if PG_MAJORVERSION_NUM >= 14
+#include <utils/multirangetypes.h>
+#endif
+}
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+
+namespace cppgres {
+
+/**
+ * @brief Built-in range (and multirange) types of a subtype
+ *
+ * Types without a built-in range type have `InvalidOid` here; values of their (user-defined)
+ * range types carry the type they were read as.
+ */
+template <typename T> struct range_type_traits {
+  static constexpr ::Oid range = InvalidOid;
+  static constexpr ::Oid multirange = InvalidOid;
+};
+
+#if PG_MAJORVERSION_NUM >= 14
+#define CPPGRES_RANGE_TYPE(T, R, M)                                                                \
+  template <> struct range_type_traits<T> {                                                        \
+    static constexpr ::Oid range = R;                                                              \
+    static constexpr ::Oid multirange = M;                                                         \
+  }
+#else
+#define CPPGRES_RANGE_TYPE(T, R, M)                                                                \
+  template <> struct range_type_traits<T> {                                                        \
+    static constexpr ::Oid range = R;                                                              \
+  }
+#endif
+
+CPPGRES_RANGE_TYPE(int32_t, INT4RANGEOID, INT4MULTIRANGEOID);
+CPPGRES_RANGE_TYPE(int64_t, INT8RANGEOID, INT8MULTIRANGEOID);
+CPPGRES_RANGE_TYPE(numeric, NUMRANGEOID, NUMMULTIRANGEOID);
+CPPGRES_RANGE_TYPE(timestamp, TSRANGEOID, TSMULTIRANGEOID);
+CPPGRES_RANGE_TYPE(timestamptz, TSTZRANGEOID, TSTZMULTIRANGEOID);
+CPPGRES_RANGE_TYPE(date, DATERANGEOID, DATEMULTIRANGEOID);
+
+#undef CPPGRES_RANGE_TYPE
+
+/**
+ * @brief Bound of a @ref cppgres::range
+ */
+template <typename T> struct range_bound {
+  /**
+   * @brief Bound value, `std::nullopt` if the bound is infinite
+   */
+  std::optional<T> value;
+  bool inclusive = false;
+};
+
+#if PG_MAJORVERSION_NUM >= 14
+template <typename T> struct multirange;
+#endif
+
+/**
+ * @brief Postgres range value
+ *
+ * Converting from a datum deserializes the bounds with `range_deserialize`; values of
+ * pass-by-reference subtypes point into the range. Converting into a datum goes through
+ * `make_range`, so discrete ranges (such as `int4range`) are canonicalized the way Postgres does.
+ *
+ * Containment and overlap checks compare the bounds in C++, following `range_cmp_bounds`. Values
+ * of the built-in range type of `T` are compared with `<=>` and don't allocate; other (such as
+ * user-defined) range types may order their subtype differently, with another operator class or
+ * collation, so their values are compared with the range type's own comparison function.
+ *
+ * ```c++
+ * cppgres::range<int64_t> r{.lower = {1, true}, .upper = {10, false}};
+ * ```
+ *
+ * @note Ranges of discrete subtypes built in C++ are not canonicalized until they are converted
+ *       into a datum; compare them with ranges read from Postgres after canonicalizing them.
+ */
+template <typename T> struct range {
+  using element_type = T;
+
+  range_bound<T> lower;
+  range_bound<T> upper;
+  bool empty = false;
+  /**
+   * @brief Range type, the built-in one for `T` by default
+   */
+  ::Oid type_oid = range_type_traits<T>::range;
+
+  /**
+   * @brief Whether `value` is in the range (like Postgres' `@>`)
+   */
+  bool contains(const T &value) const { return !empty && position(value) == 0; }
+
+  /**
+   * @brief Whether `other` is in the range (like Postgres' `@>`)
+   */
+  bool contains(const range &other) const {
+    if (other.empty) {
+      return true;
+    }
+    if (empty) {
+      return false;
+    }
+    return compare_bounds(lower, true, other.lower, true) <= 0 &&
+           compare_bounds(upper, false, other.upper, false) >= 0;
+  }
+
+  /**
+   * @brief Whether the range and `other` have values in common (like Postgres' `&&`)
+   */
+  bool overlaps(const range &other) const {
+    if (empty || other.empty) {
+      return false;
+    }
+    return (compare_bounds(lower, true, other.lower, true) >= 0 &&
+            compare_bounds(lower, true, other.upper, false) <= 0) ||
+           (compare_bounds(other.lower, true, lower, true) >= 0 &&
+            compare_bounds(other.lower, true, upper, false) <= 0);
+  }
+
+private:
+  friend struct datum_conversion<range<T>>;
+#if PG_MAJORVERSION_NUM >= 14
+  friend struct multirange<T>;
+#endif
+
+  int compare(const T &a, const T &b) const {
+    if constexpr (std::three_way_comparable<T>) {
+      if (type_oid == range_type_traits<T>::range) {
+        auto c = a <=> b;
+        return c < 0 ? -1 : (c > 0 ? 1 : 0);
+      }
+    }
+    auto *typcache = ffi_guard{::lookup_type_cache}(type_oid, TYPECACHE_RANGE_INFO);
+    if (typcache->rngelemtype == nullptr) {
+      throw std::invalid_argument(
+          cppgres::fmt::format("type with OID {} is not a range type", type_oid));
+    }
+    nullable_datum da = into_nullable_datum(a);
+    nullable_datum db = into_nullable_datum(b);
+    auto c = DatumGetInt32(ffi_guard{::FunctionCall2Coll}(
+        &typcache->rng_cmp_proc_finfo, typcache->rng_collation,
+        static_cast<const ::Datum &>(static_cast<const datum &>(da)),
+        static_cast<const ::Datum &>(static_cast<const datum &>(db))));
+    return c < 0 ? -1 : (c > 0 ? 1 : 0);
+  }
+
+  // Same as `range_cmp_bounds`
+  int compare_bounds(const range_bound<T> &b1, bool lower1, const range_bound<T> &b2,
+                     bool lower2) const {
+    if (!b1.value.has_value() && !b2.value.has_value()) {
+      return lower1 == lower2 ? 0 : (lower1 ? -1 : 1);
+    }
+    if (!b1.value.has_value()) {
+      return lower1 ? -1 : 1;
+    }
+    if (!b2.value.has_value()) {
+      return lower2 ? 1 : -1;
+    }
+    auto result = compare(*b1.value, *b2.value);
+    if (result == 0) {
+      if (!b1.inclusive && !b2.inclusive) {
+        return lower1 == lower2 ? 0 : (lower1 ? 1 : -1);
+      }
+      if (!b1.inclusive) {
+        return lower1 ? 1 : -1;
+      }
+      if (!b2.inclusive) {
+        return lower2 ? -1 : 1;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief -1 if `value` is below the lower bound, 1 if it is above the upper bound, 0 otherwise
+   */
+  int position(const T &value) const {
+    if (lower.value.has_value()) {
+      auto c = compare(*lower.value, value);
+      if (c > 0 || (c == 0 && !lower.inclusive)) {
+        return -1;
+      }
+    }
+    if (upper.value.has_value()) {
+      auto c = compare(value, *upper.value);
+      if (c > 0 || (c == 0 && !upper.inclusive)) {
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  static range decode(::TypeCacheEntry *typcache, const ::RangeBound &l, const ::RangeBound &u,
+                      bool empty, std::optional<memory_context> ctx) {
+    auto subtype = typcache->rngelemtype->type_id;
+    auto bound = [&](const ::RangeBound &b) {
+      return range_bound<T>{
+          .value = b.infinite ? std::nullopt
+                              : std::optional<T>(from_nullable_datum<T>(
+                                    nullable_datum(b.val), subtype, ctx)),
+          .inclusive = b.inclusive};
+    };
+    if (empty) {
+      return range{.empty = true, .type_oid = typcache->type_id};
+    }
+    return range{.lower = bound(l), .upper = bound(u), .type_oid = typcache->type_id};
+  }
+
+  ::RangeType *serialize(::TypeCacheEntry *typcache) const {
+    auto bound = [](const range_bound<T> &b, bool is_lower) {
+      ::Datum value = 0;
+      if (b.value.has_value()) {
+        nullable_datum nd = into_nullable_datum(*b.value);
+        value = static_cast<const ::Datum &>(static_cast<const datum &>(nd));
+      }
+      return ::RangeBound{.val = value,
+                          .infinite = !b.value.has_value(),
+                          .inclusive = b.inclusive,
+                          .lower = is_lower};
+    };
+    auto l = bound(lower, true);
+    auto u = bound(upper, false);
+#if PG_MAJORVERSION_NUM >= 16
+    return ffi_guard{::make_range}(typcache, &l, &u, empty, nullptr);
+#else
+    return ffi_guard{::make_range}(typcache, &l, &u, empty);
+#endif
+  }
+};
+
+template <typename T> struct utils::single_value<range<T>> : std::true_type {};
+
+template <typename T> struct type_traits<range<T>> {
+  type_traits() {}
+  type_traits(const range<T> &r) : oid(r.type_oid) {}
+  bool is(const type &t) {
+    if (OidIsValid(range_type_traits<T>::range) && t.oid == range_type_traits<T>::range) {
+      return true;
+    }
+    auto subtype = ffi_guard{::get_range_subtype}(t.oid);
+    return OidIsValid(subtype) && type_traits<T>().is(type{.oid = subtype});
+  }
+  type type_for() {
+    if (!OidIsValid(oid)) {
+      throw std::logic_error(cppgres::fmt::format("no built-in range type of {}",
+                                                  utils::type_name<T>()));
+    }
+    return type{.oid = oid};
+  }
+
+private:
+  ::Oid oid = range_type_traits<T>::range;
+};
+
+template <typename T> struct datum_conversion<range<T>> : default_datum_conversion<range<T>> {
+  static range<T> from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    auto *source = reinterpret_cast<::varlena *>(d.operator const ::Datum &());
+    // Only values with a short header or compressed or stored out of line are copied
+    auto *r = reinterpret_cast<::RangeType *>(ffi_guard{::pg_detoast_datum}(source));
+    if (reinterpret_cast<::varlena *>(r) != source) {
+      ctx = memory_context();
+    }
+    auto *typcache = ffi_guard{::lookup_type_cache}(RangeTypeGetOid(r), TYPECACHE_RANGE_INFO);
+    ::RangeBound l, u;
+    bool empty;
+    ffi_guard{::range_deserialize}(typcache, r, &l, &u, &empty);
+    return range<T>::decode(typcache, l, u, empty, ctx);
+  }
+
+  static datum into_datum(const range<T> &t) {
+    auto *typcache = ffi_guard{::lookup_type_cache}(type_traits<range<T>>(t).type_for().oid,
+                                                    TYPECACHE_RANGE_INFO);
+    return datum(PointerGetDatum(t.serialize(typcache)));
+  }
+};
+
+#if PG_MAJORVERSION_NUM >= 14
+/**
+ * @brief Postgres multirange value
+ *
+ * Ranges are decoded one at a time, straight from the multirange (`multirange_get_bounds`), so
+ * reading a range, checking containment or overlap (which binary search the ranges) doesn't
+ * allocate once the value is detoasted.
+ */
+template <typename T> struct multirange : public varlena {
+  using varlena::varlena;
+  using element_type = T;
+
+  /**
+   * @brief Makes a new value allocated in `ctx`, merging and sorting `ranges` like Postgres does
+   */
+  explicit multirange(std::span<const range<T>> ranges,
+                      ::Oid type = range_type_traits<T>::multirange,
+                      memory_context ctx = memory_context())
+      : varlena(make(ranges, type, ctx), ctx) {}
+
+  /**
+   * @brief Multirange type
+   */
+  ::Oid type_oid() { return MultirangeTypeGetOid(get()); }
+
+  std::size_t size() { return get()->rangeCount; }
+  bool empty() { return size() == 0; }
+
+  /**
+   * @brief Range at `i`, in order
+   *
+   * @note Values of pass-by-reference subtypes point into the multirange.
+   */
+  range<T> operator[](std::size_t i) {
+    if (i >= size()) {
+      throw std::out_of_range("multirange index out of range");
+    }
+    return at(range_type_cache(), i);
+  }
+
+  /**
+   * @brief Whether `value` is in one of the ranges (like Postgres' `@>`)
+   */
+  bool contains(const T &value) {
+    auto *typcache = range_type_cache();
+    std::size_t lo = 0, hi = size();
+    while (lo < hi) {
+      auto mid = lo + (hi - lo) / 2;
+      auto position = at(typcache, mid).position(value);
+      if (position == 0) {
+        return true;
+      }
+      if (position < 0) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Whether one of the ranges has values in common with `r` (like Postgres' `&&`)
+   */
+  bool overlaps(const range<T> &r) {
+    if (r.empty) {
+      return false;
+    }
+    auto *typcache = range_type_cache();
+    // First range that doesn't end before `r` starts; no later range can overlap if it doesn't
+    std::size_t lo = 0, hi = size();
+    while (lo < hi) {
+      auto mid = lo + (hi - lo) / 2;
+      auto current = at(typcache, mid);
+      if (current.compare_bounds(current.upper, false, r.lower, true) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo < size() && at(typcache, lo).overlaps(r);
+  }
+
+private:
+  ::MultirangeType *get() { return reinterpret_cast<::MultirangeType *>(detoasted_ptr()); }
+
+  ::TypeCacheEntry *range_type_cache() {
+    return ffi_guard{::lookup_type_cache}(type_oid(), TYPECACHE_MULTIRANGE_INFO)->rngtype;
+  }
+
+  range<T> at(::TypeCacheEntry *typcache, std::size_t i) {
+    ::RangeBound l, u;
+    ffi_guard{::multirange_get_bounds}(typcache, get(), static_cast<uint32>(i), &l, &u);
+    return range<T>::decode(typcache, l, u, false,
+                            is_detoasted() && detoasted == ptr() ? std::optional(ctx)
+                                                                 : memory_context());
+  }
+
+  static datum make(std::span<const range<T>> ranges, ::Oid type, memory_context &ctx) {
+    if (!OidIsValid(type)) {
+      throw std::logic_error(cppgres::fmt::format("no built-in multirange type of {}",
+                                                  utils::type_name<T>()));
+    }
+    auto *typcache = ffi_guard{::lookup_type_cache}(type, TYPECACHE_MULTIRANGE_INFO);
+    memory_context_scope scope(ctx);
+    auto *serialized = ctx.alloc<::RangeType *>(std::max<std::size_t>(ranges.size(), 1));
+    for (std::size_t i = 0; i < ranges.size(); i++) {
+      serialized[i] = ranges[i].serialize(typcache->rngtype);
+    }
+    return datum(PointerGetDatum(ffi_guard{::make_multirange}(
+        type, typcache->rngtype, static_cast<int32>(ranges.size()), serialized)));
+  }
+};
+
+template <typename T> struct type_traits<multirange<T>> {
+  type_traits() {}
+  type_traits(const multirange<T> &) {}
+  bool is(const type &t) {
+    if (OidIsValid(range_type_traits<T>::multirange) &&
+        t.oid == range_type_traits<T>::multirange) {
+      return true;
+    }
+    auto r = ffi_guard{::get_multirange_range}(t.oid);
+    return OidIsValid(r) && type_traits<range<T>>().is(type{.oid = r});
+  }
+  type type_for() {
+    if (!OidIsValid(range_type_traits<T>::multirange)) {
+      throw std::logic_error(cppgres::fmt::format("no built-in multirange type of {}",
+                                                  utils::type_name<T>()));
+    }
+    return type{.oid = range_type_traits<T>::multirange};
+  }
+};
+
+template <typename T>
+struct datum_conversion<multirange<T>> : default_datum_conversion<multirange<T>> {
+  static multirange<T> from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return multirange<T>{d, ctx};
+  }
+
+  static datum into_datum(const multirange<T> &t) { return t.get_datum(); }
+};
+#endif
+
+} // namespace cppgres
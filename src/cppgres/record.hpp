@@ -7,6 +7,7 @@
 #include "types.hpp"
 
 #include <algorithm>
+#include <array>
 #include <memory>
 #include <ranges>
 #include <vector>
@@ -249,7 +250,7 @@ private:
   TupleDesc populate_compact_attribute() const {
 #if PG_MAJORVERSION_NUM >= 18
     for (int i = 0; i < tupdesc->natts; i++) {
-      ffi_guard{::populate_compact_attribute}(tupdesc, i);
+      ffi_unguarded{::populate_compact_attribute}(tupdesc, i);
     }
 #endif
     return tupdesc;
@@ -447,6 +448,99 @@ template <> struct type_traits<record> {
   constexpr type type_for() { return {.oid = RECORDOID}; }
 };
 
+/**
+ * @brief Compile-time schema of a row type
+ *
+ * Describes a tuple-like C++ type (`std::tuple` or an aggregate) as a fixed sequence of columns
+ * typed by their `type_traits`.
+ */
+template <typename T> struct row_schema {
+  /**
+   * @brief Number of columns
+   */
+  static constexpr std::size_t columns = utils::tuple_size_v<T>;
+
+  /**
+   * @brief Checks that a tuple descriptor matches the schema
+   *
+   * @throws std::runtime_error if the number of attributes doesn't match
+   * @throws std::invalid_argument if an attribute is of an incompatible type
+   */
+  static void check(::TupleDesc desc) {
+    if (static_cast<std::size_t>(desc->natts) != columns) {
+      throw std::runtime_error(
+          cppgres::fmt::format("expected record with {} value{}, got {} instead", columns,
+                               columns == 1 ? "" : "s", desc->natts));
+    }
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (([&] {
+         auto oid = TupleDescAttr(desc, Is)->atttypid;
+         using typ = utils::tuple_element_t<Is, T>;
+         if (!type_traits<typ>().is(type{.oid = oid})) {
+           throw std::invalid_argument(
+               cppgres::fmt::format("invalid type in record's position {} ({}), got OID {}", Is,
+                                    utils::type_name<typ>(), oid));
+         }
+       }()),
+       ...);
+    }(std::make_index_sequence<columns>{});
+  }
+
+  /**
+   * @brief Converts every column of a row into a datum exactly once
+   */
+  static void into_datums(const T &row, std::array<::Datum, columns> &values,
+                          std::array<bool, columns> &isnull) {
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (([&] {
+         nullable_datum nd = into_nullable_datum(utils::get<Is>(row));
+         isnull[Is] = nd.is_null();
+         values[Is] = isnull[Is] ? ::Datum(0)
+                                 : static_cast<const ::Datum &>(static_cast<const datum &>(nd));
+       }()),
+       ...);
+    }(std::make_index_sequence<columns>{});
+  }
+};
+
+/**
+ * @brief Tuple descriptor of a composite type, bound to a row schema
+ *
+ * The descriptor is taken from the type cache and checked against the schema of `T` once per
+ * backend. It is only looked up and checked again when the type cache reports that the composite
+ * type has changed (or when a different type is requested).
+ *
+ * @note The returned descriptor is owned by the type cache and is only guaranteed to be valid
+ *       until the next invalidation is processed, so it should be used right away.
+ */
+template <typename T> struct composite_descriptor {
+  /**
+   * @brief Get the descriptor for composite type `t`
+   *
+   * @throws std::invalid_argument if `t` is not a composite type or doesn't match the schema
+   */
+  static ::TupleDesc get(const type &t) {
+    if (entry == nullptr || type_oid != t.oid || entry->tupDesc == nullptr ||
+        entry->tupDesc_identifier != identifier) {
+      auto *e = ffi_guard{::lookup_type_cache}(t.oid, TYPECACHE_TUPDESC);
+      if (e->tupDesc == nullptr) {
+        throw std::invalid_argument("not a composite type");
+      }
+      row_schema<T>::check(e->tupDesc);
+      // Type cache entries live as long as the backend does
+      entry = e;
+      type_oid = t.oid;
+      identifier = e->tupDesc_identifier;
+    }
+    return entry->tupDesc;
+  }
+
+private:
+  static inline ::TypeCacheEntry *entry = nullptr;
+  static inline ::Oid type_oid = InvalidOid;
+  static inline ::uint64 identifier = 0;
+};
+
 template <typename T>
 concept composite_type = requires {
   { T::composite_type() } -> std::same_as<type>;
@@ -454,29 +548,51 @@ concept composite_type = requires {
 
 template <composite_type T> struct datum_conversion<T> : default_datum_conversion<T> {
   static T from_datum(const datum &d, oid oid_, std::optional<memory_context> ctx) {
-    if (oid_ != T::composite_type().oid) {
+    auto ct = T::composite_type();
+    if (oid_ != ct.oid) {
       throw std::runtime_error(fmt::format("invalid type: expected composite type {} got {}",
-                                           T::composite_type().name(), type{.oid = oid_}.name()));
+                                           ct.name(), type{.oid = oid_}.name()));
     }
     auto mctx = ctx.has_value() ? ctx.value() : memory_context();
-    record rec{reinterpret_cast<HeapTupleHeader>(ffi_guard{::pg_detoast_datum}(
-                   reinterpret_cast<struct ::varlena *>(d.operator const ::Datum &()))),
-               mctx};
+    auto header = reinterpret_cast<HeapTupleHeader>(ffi_guard{::pg_detoast_datum}(
+        reinterpret_cast<struct ::varlena *>(d.operator const ::Datum &())));
+
+    constexpr auto columns = row_schema<T>::columns;
+    std::array<::Datum, columns> values;
+    std::array<bool, columns> isnull;
+    std::array<::Oid, columns> types;
+    {
+      ::HeapTupleData tuple;
+      tuple.t_len = HeapTupleHeaderGetDatumLength(header);
+      ItemPointerSetInvalid(&tuple.t_self);
+      tuple.t_tableOid = InvalidOid;
+      tuple.t_data = header;
+      auto desc = composite_descriptor<T>::get(ct);
+      ffi_unguarded{::heap_deform_tuple}(&tuple, desc, values.data(), isnull.data());
+      for (std::size_t i = 0; i < columns; i++) {
+        types[i] = TupleDescAttr(desc, i)->atttypid;
+      }
+    }
+
     return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
       return T{([&] {
-        return from_nullable_datum<utils::tuple_element_t<Is, T>>(rec.get_attribute(Is),
-                                                                  rec.attribute_type(Is).oid, mctx);
+        ::NullableDatum nd = {.value = values[Is], .isnull = isnull[Is]};
+        return from_nullable_datum<utils::tuple_element_t<Is, T>>(nullable_datum(nd), types[Is],
+                                                                  mctx);
       }())...};
-    }(std::make_index_sequence<utils::tuple_size_v<T>>{});
+    }(std::make_index_sequence<columns>{});
   }
 
   static datum into_datum(const T &t) {
-    auto res = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-      tuple_descriptor td(T::composite_type());
-      record rec{td, utils::get<Is>(t)...};
-      return datum(ffi_guard{::heap_copy_tuple_as_datum}(rec, rec));
-    }(std::make_index_sequence<utils::tuple_size_v<T>>{});
-    return res;
+    constexpr auto columns = row_schema<T>::columns;
+    std::array<::Datum, columns> values;
+    std::array<bool, columns> isnull;
+    // Convert first: conversions may process invalidations, and the descriptor is only
+    // guaranteed to be valid until then
+    row_schema<T>::into_datums(t, values, isnull);
+    auto desc = composite_descriptor<T>::get(T::composite_type());
+    auto tuple = ffi_guard{::heap_form_tuple}(desc, values.data(), isnull.data());
+    return datum(ffi_guard{::HeapTupleHeaderGetDatum}(tuple->t_data));
   }
 };
 template <composite_type T> struct type_traits<T> {
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <iterator>
+#include <type_traits>
+#include <utility>
 
 #include "datum.hpp"
 #include "imports.h"
@@ -11,9 +13,14 @@
 
 namespace cppgres {
 
+/**
+ * @brief Range of values returned by a set-returning function
+ *
+ * Ranges that are themselves convertible into a datum (such as arrays) are single values.
+ */
 template <typename I>
 concept datumable_iterator =
-    requires(I i) {
+    !convertible_into_datum<I> && requires(I i) {
       { std::begin(i) } -> std::input_iterator;
       { std::end(i) } -> std::sentinel_for<decltype(std::begin(i))>;
     } &&
@@ -29,4 +36,41 @@ struct type_traits<I> {
   bool is(type &t) { return t.oid == RECORDOID; }
 };
 
+/**
+ * @brief Opts a set-returning function into value-per-call mode
+ *
+ * By default, @ref cppgres::postgres_function materializes the entire set into a tuplestore
+ * before returning the first row. Returning a set wrapped into `value_per_call` instead
+ * (when the caller allows `SFRM_ValuePerCall`) keeps the live range and its iterator in a
+ * per-query memory context across calls and yields one row per call, so a lazily evaluated
+ * range (such as `std::generator`) is only advanced as far as the executor actually reads it.
+ *
+ * The range is destroyed once it is exhausted or, if the executor stops early (for example,
+ * under `LIMIT`), when the calling expression context is shut down.
+ *
+ * @note Since the range is suspended between calls, it must not keep state that is bound to a
+ *       single call, like a live @ref cppgres::spi_executor.
+ *
+ * @note If the caller doesn't allow value-per-call mode, the set is materialized as usual.
+ */
+template <datumable_iterator R> struct value_per_call {
+  using range_type = R;
+
+  explicit value_per_call(R range) : range(std::move(range)) {}
+
+  auto begin() { return std::begin(range); }
+  auto end() { return std::end(range); }
+
+private:
+  R range;
+};
+
+template <typename R> value_per_call(R) -> value_per_call<R>;
+
+template <typename T> struct is_value_per_call : std::false_type {};
+template <typename R> struct is_value_per_call<value_per_call<R>> : std::true_type {};
+
+template <typename T>
+concept value_per_call_set = is_value_per_call<T>::value;
+
 } // namespace cppgres
@@ -3,17 +3,25 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <optional>
 #include <span>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 #include "datum.hpp"
 #include "guard.hpp"
 #include "imports.h"
 #include "utils/utils.hpp"
 
+extern "C" {
+#include <access/detoast.h>
+}
+
 namespace cppgres {
 
 /**
@@ -73,28 +81,33 @@ struct non_by_value_type {
   non_by_value_type(std::pair<const struct datum &, std::optional<memory_context>> init)
       : non_by_value_type(init.first, init.second) {}
   non_by_value_type(const struct datum &datum, std::optional<memory_context> ctx)
-      : value_datum(datum),
-        ctx(tracking_memory_context(ctx.has_value() ? *ctx : top_memory_context())) {}
+      : value_datum(datum), ctx(ctx.has_value() ? *ctx : top_memory_context()),
+        generation(this->ctx) {}
 
   non_by_value_type(const non_by_value_type &other)
-      : value_datum(other.value_datum), ctx(other.ctx) {}
+      : value_datum(other.value_datum), ctx(other.ctx), generation(other.generation) {}
   non_by_value_type(non_by_value_type &&other) noexcept
-      : value_datum(std::move(other.value_datum)), ctx(std::move(other.ctx)) {}
+      : value_datum(std::move(other.value_datum)), ctx(std::move(other.ctx)),
+        generation(other.generation) {}
   non_by_value_type &operator=(non_by_value_type &&other) noexcept {
     value_datum = std::move(other.value_datum);
     ctx = std::move(other.ctx);
+    generation = other.generation;
     return *this;
   }
 
-  memory_context &get_memory_context() { return ctx.get_memory_context(); }
+  memory_context &get_memory_context() { return ctx; }
 
   datum get_datum() const { return value_datum; }
 
 protected:
   datum value_datum;
-  tracking_memory_context<memory_context> ctx;
+  memory_context ctx;
+  // Values in `TopMemoryContext` (the default) are not tracked, so arguments of a function call
+  // are borrowed for the duration of the call at no cost
+  memory_context_generation generation;
   void *ptr(bool tracked = true) const {
-    if (tracked && ctx.resets() > 0) {
+    if (tracked && !generation.valid()) {
       throw pointer_gone_exception();
     }
     return reinterpret_cast<void *>(value_datum.operator const ::Datum &());
@@ -103,32 +116,197 @@ protected:
 
 static_assert(std::copy_constructible<non_by_value_type>);
 
+using byte_array = std::span<const std::byte>;
+
 struct varlena : public non_by_value_type {
   using non_by_value_type::non_by_value_type;
 
+  /**
+   * @brief Reads a value window by window
+   *
+   * A single-pass input range of consecutive windows of the value. Values stored out of line
+   * without compression (`STORAGE EXTERNAL`) are fetched one window at a time, into memory that
+   * is reused for every window, so memory use is bounded by the window size. Other values are
+   * detoasted once and read from memory.
+   *
+   * @note Every window is only valid until the range advances past it.
+   *
+   * @throws pointer_gone_exception when advancing if the memory of the value is gone
+   */
+  struct chunk_reader {
+    friend struct varlena;
+
+    struct iterator {
+      using iterator_category = std::input_iterator_tag;
+      using value_type = byte_array;
+      using difference_type = std::ptrdiff_t;
+
+      iterator() noexcept : r(nullptr) {}
+      explicit iterator(chunk_reader *r) noexcept : r(r) {}
+
+      byte_array operator*() const { return r->window; }
+      iterator &operator++() {
+        r->advance();
+        return *this;
+      }
+      void operator++(int) { ++*this; }
+
+      bool operator==(std::default_sentinel_t) const { return r->exhausted; }
+
+    private:
+      chunk_reader *r;
+    };
+
+    chunk_reader(chunk_reader &&) = default;
+    chunk_reader(const chunk_reader &) = delete;
+    chunk_reader &operator=(const chunk_reader &) = delete;
+    chunk_reader &operator=(chunk_reader &&) = delete;
+
+    /**
+     * @brief Reads the first window, if not read yet
+     */
+    iterator begin() {
+      if (!started) {
+        started = true;
+        advance();
+      }
+      return iterator(this);
+    }
+    std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+  private:
+    chunk_reader(::varlena *source, const std::byte *data, std::size_t size,
+                 std::size_t window_size, memory_context_generation generation)
+        : source(source), data(data), size(size), window_size(window_size),
+          generation(generation) {}
+
+    void advance() {
+      // Like the accessors of the value, make sure its memory (or that of its copy) is still there
+      if (!generation.valid()) {
+        throw pointer_gone_exception();
+      }
+      if (offset >= size) {
+        exhausted = true;
+        return;
+      }
+      auto length = std::min(window_size, size - offset);
+      if (data != nullptr) {
+        window = {data + offset, length};
+      } else {
+        context.reset();
+        auto *slice = context([&]() {
+          return ffi_guard{::pg_detoast_datum_slice}(source, static_cast<int32>(offset),
+                                                     static_cast<int32>(length));
+        });
+        window = {reinterpret_cast<const std::byte *>(VARDATA_ANY(slice)),
+                  VARSIZE_ANY_EXHDR(slice)};
+      }
+      offset += length;
+    }
+
+    ::varlena *source;
+    const std::byte *data;
+    std::size_t size;
+    std::size_t window_size;
+    memory_context_generation generation;
+    std::size_t offset = 0;
+    byte_array window;
+    bool started = false;
+    bool exhausted = false;
+    alloc_set_memory_context context;
+  };
+
   operator void *() { return VARDATA_ANY(detoasted_ptr()); }
 
   datum get_datum() const { return value_datum; }
 
   bool is_detoasted() const { return detoasted != nullptr; }
 
+  /**
+   * @brief Size of the value in bytes, without detoasting it
+   */
+  std::size_t size() {
+    if (detoasted != nullptr) {
+      return VARSIZE_ANY_EXHDR(detoasted_ptr());
+    }
+    return ffi_guard{::toast_raw_datum_size}(PointerGetDatum(ptr())) - VARHDRSZ;
+  }
+
+  /**
+   * @brief Reads the value in windows of `window_size` bytes
+   *
+   * @see chunk_reader
+   */
+  chunk_reader chunks(std::size_t window_size) {
+    if (window_size == 0) {
+      throw std::invalid_argument("window size must be positive");
+    }
+    if (detoasted == nullptr) {
+      auto *source = reinterpret_cast<::varlena *>(ptr());
+      if (VARATT_IS_EXTERNAL_ONDISK(source)) {
+        ::varatt_external toast_pointer;
+        VARATT_EXTERNAL_GET_POINTER(toast_pointer, source);
+        if (!VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer)) {
+          return {source, nullptr, static_cast<std::size_t>(toast_pointer.va_rawsize - VARHDRSZ),
+                  window_size, generation};
+        }
+      }
+    }
+    auto *value = detoasted_ptr();
+    return {nullptr, reinterpret_cast<const std::byte *>(VARDATA_ANY(value)),
+            VARSIZE_ANY_EXHDR(value), window_size, detoasted_generation};
+  }
+
 protected:
+  /**
+   * @brief Returns `length` bytes of the value starting at `offset`
+   *
+   * Compressed or out-of-line values that haven't been detoasted yet are not detoasted: only the
+   * slice is (with `pg_detoast_datum_slice`, allocating it in the current memory context). The
+   * slice is shorter than requested if the value ends before.
+   */
+  byte_array slice_bytes(std::size_t offset, std::size_t length) {
+    auto *source = reinterpret_cast<::varlena *>(detoasted != nullptr ? detoasted_ptr() : ptr());
+    if (VARATT_IS_EXTERNAL(source) || VARATT_IS_COMPRESSED(source)) {
+      if (offset > PG_INT32_MAX) {
+        return {};
+      }
+      auto *slice = ffi_guard{::pg_detoast_datum_slice}(
+          source, static_cast<int32>(offset),
+          static_cast<int32>(std::min<std::size_t>(length, PG_INT32_MAX)));
+      return {reinterpret_cast<const std::byte *>(VARDATA_ANY(slice)), VARSIZE_ANY_EXHDR(slice)};
+    }
+    auto size = VARSIZE_ANY_EXHDR(source);
+    offset = std::min(offset, size);
+    return {reinterpret_cast<const std::byte *>(VARDATA_ANY(source)) + offset,
+            std::min(length, size - offset)};
+  }
+
+  /**
+   * @brief Value to read with `VARDATA_ANY`: the value itself if it is inline and not
+   * compressed (including with a short header), its detoasted copy otherwise
+   */
+  ::varlena *readable_ptr() {
+    auto *source = reinterpret_cast<::varlena *>(detoasted != nullptr ? detoasted_ptr() : ptr());
+    if (VARATT_IS_EXTERNAL(source) || VARATT_IS_COMPRESSED(source)) {
+      return reinterpret_cast<::varlena *>(detoasted_ptr());
+    }
+    return source;
+  }
+
   void *detoasted = nullptr;
-  std::optional<tracking_memory_context<memory_context>> detoasted_ctx;
+  memory_context_generation detoasted_generation;
   void *detoasted_ptr() {
     if (detoasted != nullptr) {
-      if (detoasted_ctx.has_value() && detoasted_ctx->resets() > 0) {
+      if (!detoasted_generation.valid()) {
         throw pointer_gone_exception();
       }
       return detoasted;
     }
     auto *source = reinterpret_cast<::varlena *>(ptr());
     detoasted = ffi_guard{::pg_detoast_datum}(source);
-    if (detoasted == source) {
-      detoasted_ctx = ctx;
-    } else {
-      detoasted_ctx.emplace(memory_context());
-    }
+    detoasted_generation =
+        detoasted == source ? generation : memory_context_generation(::CurrentMemoryContext);
     return detoasted;
   }
 };
@@ -139,9 +317,17 @@ struct text : public varlena {
   operator std::string_view() {
     return {static_cast<char *>(this->operator void *()), VARSIZE_ANY_EXHDR(this->detoasted_ptr())};
   }
-};
 
-using byte_array = std::span<const std::byte>;
+  /**
+   * @brief Returns `length` bytes of the text starting at byte `offset`, detoasting only them
+   *
+   * @note Offsets are in bytes: slices of text in multibyte encodings can split characters.
+   */
+  std::string_view slice(std::size_t offset, std::size_t length) {
+    auto bytes = slice_bytes(offset, length);
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+};
 
 struct bytea : public varlena {
   using varlena::varlena;
@@ -160,8 +346,135 @@ struct bytea : public varlena {
     return {reinterpret_cast<std::byte *>(this->operator void *()),
             VARSIZE_ANY_EXHDR(this->detoasted_ptr())};
   }
+
+  /**
+   * @brief Returns `length` bytes starting at `offset`, detoasting only them
+   */
+  byte_array slice(std::size_t offset, std::size_t length) { return slice_bytes(offset, length); }
 };
 
+/**
+ * @brief Builds a @ref cppgres::text or @ref cppgres::bytea value in place
+ *
+ * The value is written directly into a varlena buffer allocated in the target memory context,
+ * that grows as needed. Its header is kept up to date as the value is written, so the buffer is
+ * a valid value at any time and converting the builder into a datum
+ * (including returning it from a @ref cppgres::postgres_function) uses that buffer as is, without
+ * copying it.
+ *
+ * The builder can be used with `std::back_inserter`, for example as an output iterator for
+ * `std::format_to`.
+ *
+ * @note The buffer belongs to the memory context and not to the builder, so it outlives it.
+ *       Appending to the builder after it was converted into a datum may reallocate the buffer
+ *       and invalidate that datum.
+ * @note A builder that was moved from has no buffer; using it throws `std::logic_error`.
+ */
+template <typename T> requires std::same_as<T, text> || std::same_as<T, bytea>
+struct varlena_builder {
+  using value_type = char;
+
+  /**
+   * @brief Allocates a builder for `capacity` bytes in the memory context `ctx`
+   */
+  explicit varlena_builder(std::size_t capacity = 64, memory_context ctx = memory_context())
+      : ctx(ctx), buffer(allocate(this->ctx, std::max<std::size_t>(capacity, 1))),
+        cap(std::max<std::size_t>(capacity, 1)) {
+    SET_VARSIZE(buffer, VARHDRSZ);
+  }
+
+  varlena_builder(const varlena_builder &) = delete;
+  varlena_builder &operator=(const varlena_builder &) = delete;
+  varlena_builder(varlena_builder &&other) noexcept
+      : ctx(other.ctx), buffer(std::exchange(other.buffer, nullptr)),
+        cap(std::exchange(other.cap, 0)), length(std::exchange(other.length, 0)) {}
+  varlena_builder &operator=(varlena_builder &&other) noexcept {
+    ctx = other.ctx;
+    buffer = std::exchange(other.buffer, nullptr);
+    cap = std::exchange(other.cap, 0);
+    length = std::exchange(other.length, 0);
+    return *this;
+  }
+
+  void push_back(char c) {
+    if (length == cap) {
+      reserve(length + 1);
+    }
+    get_buffer()[VARHDRSZ + length++] = c;
+    SET_VARSIZE(buffer, VARHDRSZ + length);
+  }
+
+  varlena_builder &append(std::string_view s) {
+    reserve(length + s.size());
+    std::copy(s.begin(), s.end(), get_buffer() + VARHDRSZ + length);
+    length += s.size();
+    SET_VARSIZE(buffer, VARHDRSZ + length);
+    return *this;
+  }
+
+  varlena_builder &append(byte_array bytes) {
+    return append(std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+  }
+
+  /**
+   * @brief Makes sure there is room for at least `n` bytes, growing geometrically
+   */
+  void reserve(std::size_t n) {
+    get_buffer();
+    if (n <= cap) {
+      return;
+    }
+    if (n > MaxAllocSize - VARHDRSZ) {
+      throw std::length_error("value is too large");
+    }
+    auto new_cap = std::min<std::size_t>(std::max(n, cap * 2), MaxAllocSize - VARHDRSZ);
+    buffer = static_cast<char *>(ffi_guard{::repalloc}(buffer, VARHDRSZ + new_cap));
+    cap = new_cap;
+  }
+
+  std::size_t size() const { return length; }
+  std::size_t capacity() const { return cap; }
+  char *data() { return get_buffer() + VARHDRSZ; }
+
+  /**
+   * @brief Contents built so far
+   */
+  std::string_view view() const { return {get_buffer() + VARHDRSZ, length}; }
+
+  /**
+   * @brief Datum of the value built so far
+   */
+  datum get_datum() const { return datum(PointerGetDatum(get_buffer())); }
+
+  /**
+   * @brief Value built so far
+   */
+  T value() const { return T(get_datum(), ctx); }
+
+private:
+  char *get_buffer() const {
+    if (buffer == nullptr) {
+      throw std::logic_error("varlena builder was moved from");
+    }
+    return buffer;
+  }
+
+  static char *allocate(memory_context &ctx, std::size_t capacity) {
+    if (capacity > MaxAllocSize - VARHDRSZ) {
+      throw std::length_error("value is too large");
+    }
+    return ctx.alloc<char>(VARHDRSZ + capacity);
+  }
+
+  memory_context ctx;
+  char *buffer;
+  std::size_t cap;
+  std::size_t length = 0;
+};
+
+using text_builder = varlena_builder<text>;
+using bytea_builder = varlena_builder<bytea>;
+
 template <typename T>
 concept flattenable = requires(T t, std::span<std::byte> span) {
   { T::type() } -> std::same_as<type>;
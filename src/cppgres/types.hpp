@@ -136,6 +136,13 @@ template <> struct type_traits<bytea> {
   constexpr type type_for() { return type{.oid = BYTEAOID}; }
 };
 
+template <typename T> struct type_traits<varlena_builder<T>> {
+  type_traits() {}
+  type_traits(const varlena_builder<T> &) {}
+  bool is(const type &t) { return type_traits<T>().is(t); }
+  constexpr type type_for() { return type_traits<T>().type_for(); }
+};
+
 template <> struct type_traits<char *> {
   type_traits() {}
   type_traits(const char *&) {}
@@ -277,6 +284,11 @@ template <> struct datum_conversion<byte_array> : default_datum_conversion<byte_
   }
 };
 
+template <typename T>
+struct datum_conversion<varlena_builder<T>> : default_datum_conversion<varlena_builder<T>> {
+  static datum into_datum(const varlena_builder<T> &t) { return t.get_datum(); }
+};
+
 // Specializations for std::string_view and std::string.
 // Here we re-use the conversion for text.
 template <> struct datum_conversion<std::string_view> : default_datum_conversion<std::string_view> {
@@ -360,6 +372,76 @@ template <typename T> struct datum_conversion<T, std::enable_if_t<utils::is_opti
   }
 };
 
+/**
+ * @brief Value that is converted from its datum on first access
+ *
+ * Useful for arguments of @ref cppgres::postgres_function that may not be used at all: their
+ * conversion (including detoasting) is only paid for if they are accessed.
+ *
+ * @note The datum must remain valid for as long as the value hasn't been accessed, which is the
+ *       case for function arguments for the duration of the call.
+ *
+ * @tparam T type to convert into; if it is `std::optional`, null datums convert into
+ *           `std::nullopt`, otherwise accessing a null datum throws.
+ */
+template <convertible_from_nullable_datum T> struct lazy {
+  lazy(const nullable_datum &d, oid oid, std::optional<memory_context> ctx = std::nullopt)
+      : value_datum(d), typ(oid), ctx(std::move(ctx)) {}
+
+  /**
+   * @brief Converts the datum (unless it has already been converted) and returns the value
+   */
+  T &get() {
+    if (!value.has_value()) {
+      value.emplace(from_nullable_datum<T>(value_datum, typ, ctx));
+    }
+    return *value;
+  }
+
+  T &operator*() { return get(); }
+  T *operator->() { return &get(); }
+
+  /**
+   * @brief Returns true if the datum is null; doesn't convert it
+   */
+  bool is_null() const { return value_datum.is_null(); }
+
+  /**
+   * @brief Returns true if the datum has been converted
+   */
+  bool converted() const { return value.has_value(); }
+
+  /**
+   * @brief Unconverted datum
+   */
+  const nullable_datum &get_nullable_datum() const { return value_datum; }
+
+private:
+  nullable_datum value_datum;
+  oid typ;
+  std::optional<memory_context> ctx;
+  std::optional<T> value;
+};
+
+template <typename T> struct datum_conversion<lazy<T>> {
+  static lazy<T> from_nullable_datum(const nullable_datum &d, const oid oid,
+                                     std::optional<memory_context> context = std::nullopt) {
+    return {d, oid, context};
+  }
+
+  static lazy<T> from_datum(const datum &d, oid oid,
+                            std::optional<memory_context> ctx = std::nullopt) {
+    return {nullable_datum(d), oid, ctx};
+  }
+};
+
+template <typename T> struct type_traits<lazy<T>> {
+  type_traits() {}
+  type_traits(const lazy<T> &) {}
+  bool is(const type &t) { return type_traits<T>().is(t); }
+  constexpr type type_for() { return type_traits<T>().type_for(); }
+};
+
 /**
  * @brief Type identified by its name
  *
@@ -39,4 +39,14 @@ template <data_length_available S> owned_cstring to_cstring(S &&string) {
   return std::string(string.data(), string.length());
 }
 
+template <is_cstring S> std::string_view to_string_view(S string) { return string; }
+
+template <c_str_available S> std::string_view to_string_view(S &&string) {
+  return string.c_str();
+}
+
+template <data_length_available S> std::string_view to_string_view(S &&string) {
+  return {string.data(), string.length()};
+}
+
 } // namespace cppgres::utils
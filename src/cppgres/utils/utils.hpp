@@ -6,6 +6,7 @@
 #include <optional>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "pfr.hpp"
@@ -63,6 +64,16 @@ template <typename T> constexpr std::string_view type_name() {
 #endif
 }
 
+/**
+ * @brief Marks an aggregate as a single value rather than a composite of its members
+ *
+ * Specializing this as `std::true_type` keeps Boost.PFR from taking the type apart, so it is
+ * converted as a whole (e.g. a range or an interval).
+ */
+template <typename T> struct single_value : std::false_type {};
+
+template <typename T> constexpr bool single_value_v = single_value<T>::value;
+
 template <typename T, typename = void> struct tuple_traits_impl {
   using tuple_size_type = std::integral_constant<std::size_t, 1>;
 
@@ -90,9 +101,10 @@ struct tuple_traits_impl<T, std::void_t<decltype(std::tuple_size<T>::value)>> {
 };
 
 // Specialization: for aggregates that Boost.PFR can handle.
-// This specialization is enabled if the type is an aggregate
+// This specialization is enabled if the type is an aggregate that isn't a single value
 #if CPPGRES_USE_BOOST_PFR
-template <typename T> struct tuple_traits_impl<T, std::enable_if_t<std::is_aggregate_v<T>>> {
+template <typename T>
+struct tuple_traits_impl<T, std::enable_if_t<std::is_aggregate_v<T> && !single_value_v<T>>> {
   using tuple_size_type = boost::pfr::tuple_size<T>;
 
   template <std::size_t I, typename U = T> static constexpr decltype(auto) get(U &&t) noexcept {
@@ -127,7 +139,7 @@ concept std_tuple = is_std_tuple<T>::value;
 
 template <typename T> decltype(auto) tie(T &val) {
 #if CPPGRES_USE_BOOST_PFR == 1
-  if constexpr (std::is_aggregate_v<T>) {
+  if constexpr (std::is_aggregate_v<T> && !single_value_v<T>) {
     return boost::pfr::structure_tie(val);
   } else
 #endif
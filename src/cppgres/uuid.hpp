@@ -0,0 +1,91 @@
+/**
+ * \file
+ */
+#pragma once
+
+#include "datum.hpp"
+#include "imports.h"
+#include "memory.hpp"
+#include "type.hpp"
+#include "types.hpp"
+
+extern "C" {
+#include <utils/uuid.h>
+}
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+namespace cppgres {
+
+/**
+ * @brief Postgres `uuid`
+ *
+ * Converting from a datum doesn't copy the value: its bytes are read where the datum points to.
+ */
+struct uuid : public non_by_value_type {
+  using non_by_value_type::non_by_value_type;
+
+  /**
+   * @brief Copies `bytes` into a new value allocated in `ctx`
+   */
+  explicit uuid(const std::array<std::byte, UUID_LEN> &bytes, memory_context ctx = memory_context())
+      : non_by_value_type(
+            [&]() {
+              auto *u = ctx.alloc<::pg_uuid_t>();
+              std::memcpy(u->data, bytes.data(), UUID_LEN);
+              return datum(UUIDPGetDatum(u));
+            }(),
+            ctx) {}
+
+  /**
+   * @brief Bytes of the value
+   */
+  std::span<const std::byte, UUID_LEN> bytes() const {
+    return std::span<const std::byte, UUID_LEN>(
+        reinterpret_cast<const std::byte *>(static_cast<::pg_uuid_t *>(ptr())->data), UUID_LEN);
+  }
+
+  /**
+   * @brief Copy of the bytes of the value
+   */
+  std::array<std::byte, UUID_LEN> to_array() const {
+    std::array<std::byte, UUID_LEN> result;
+    std::ranges::copy(bytes(), result.begin());
+    return result;
+  }
+
+  /**
+   * @brief Compares values bytewise, like Postgres does
+   */
+  friend std::strong_ordering operator<=>(const uuid &a, const uuid &b) {
+    auto cmp = std::memcmp(a.bytes().data(), b.bytes().data(), UUID_LEN);
+    return cmp < 0 ? std::strong_ordering::less
+                   : (cmp > 0 ? std::strong_ordering::greater : std::strong_ordering::equal);
+  }
+
+  friend bool operator==(const uuid &a, const uuid &b) {
+    return (a <=> b) == std::strong_ordering::equal;
+  }
+};
+
+template <> struct type_traits<uuid> {
+  type_traits() {}
+  type_traits(const uuid &) {}
+  bool is(const type &t) { return t.oid == UUIDOID; }
+  constexpr type type_for() { return type{.oid = UUIDOID}; }
+};
+
+template <> struct datum_conversion<uuid> : default_datum_conversion<uuid> {
+  static uuid from_datum(const datum &d, oid, std::optional<memory_context> ctx) {
+    return uuid{d, ctx};
+  }
+
+  static datum into_datum(const uuid &t) { return t.get_datum(); }
+};
+
+} // namespace cppgres
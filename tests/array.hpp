@@ -0,0 +1,201 @@
+#pragma once
+
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tests.hpp"
+
+namespace tests {
+
+postgres_function(array_sum, ([](std::span<const double> values) {
+                    return std::accumulate(values.begin(), values.end(), 0.0);
+                  }));
+
+postgres_function(array_scale, ([](cppgres::array<int32_t> a, int32_t k) {
+                    std::vector<int32_t> scaled;
+                    scaled.reserve(a.size());
+                    for (auto v : a.values()) {
+                      scaled.push_back(v * k);
+                    }
+                    return cppgres::make_array(std::span<const int32_t>(scaled), a.dims());
+                  }));
+
+postgres_function(array_non_null_count, ([](cppgres::array<int64_t> a) {
+                    int32_t count = 0;
+                    for (auto v : a) {
+                      count += v.has_value();
+                    }
+                    return count;
+                  }));
+
+// Calls of `expanded_array_append` that received a read/write expanded array
+static int64_t expanded_array_rw_states = 0;
+
+postgres_function(expanded_array_append, ([](cppgres::datum state, std::optional<int64_t> v) {
+                    if (VARATT_IS_EXTERNAL_EXPANDED_RW(
+                            DatumGetPointer(state.operator const ::Datum &()))) {
+                      expanded_array_rw_states++;
+                    }
+                    cppgres::expanded_array<int64_t> a(state);
+                    a.push_back(v);
+                    return a;
+                  }));
+
+add_test(array_conversions, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function array_sum(float8[]) returns float8 language c as '{0}';"
+               "create function array_scale(int4[], int4) returns int4[] language c as '{0}';"
+               "create function array_non_null_count(int8[]) returns int4 language c as '{0}'",
+               get_library_name()));
+
+           auto sum = spi.query<double>("select array_sum(array[1.5, 2.5, 3]::float8[])");
+           result = result && _assert(sum.begin()[0] == 7.0);
+
+           auto scaled = spi.query<std::string>(
+               "select array_scale('{{1,2,3},{4,5,6}}'::int4[], 10)::text");
+           result = result && _assert(scaled.begin()[0] == "{{10,20,30},{40,50,60}}");
+
+           auto count =
+               spi.query<int32_t>("select array_non_null_count(array[1, null, 3]::int8[])");
+           result = result && _assert(count.begin()[0] == 2);
+
+           // Arrays with nulls can't be viewed as spans
+           {
+             cppgres::internal_subtransaction sub(false);
+             bool exception_raised = false;
+             try {
+               spi.query<double>("select array_sum(array[1, null]::float8[])");
+             } catch (std::exception &e) {
+               exception_raised = true;
+             }
+             result = result && _assert(exception_raised);
+           }
+
+           return result;
+         }));
+
+add_test(array_access, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           auto matrix = spi.query<cppgres::array<int32_t>>(
+                                "select '[0:1][1:3]={{1,2,3},{4,5,6}}'::int4[]")
+                             .begin()[0];
+           result = result && _assert(matrix.ndim() == 2);
+           result = result && _assert(matrix.dims()[0] == 2 && matrix.dims()[1] == 3);
+           result = result && _assert(matrix.lower_bounds()[0] == 0);
+           result = result && _assert(matrix.size() == 6);
+           result = result && _assert(matrix.values()[5] == 6);
+           result = result && _assert(matrix.at({1, 1}) == 4);
+           result = result && _assert(matrix[2] == 3);
+
+           bool exception_raised = false;
+           try {
+             matrix.at({2, 1});
+           } catch (std::out_of_range &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           exception_raised = false;
+           try {
+             matrix[6];
+           } catch (std::out_of_range &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           auto texts =
+               spi.query<cppgres::array<std::string_view>>("select array['a', null, 'c']")
+                   .begin()[0];
+           result = result && _assert(texts.has_nulls());
+           result = result && _assert(texts[0] == "a");
+           result = result && _assert(!texts[1].has_value());
+           result = result && _assert(texts[2] == "c");
+
+           std::vector<double> values = {1.0, 2.0};
+           auto built = cppgres::make_array(std::span<const double>(values));
+           result = result && _assert(built.size() == 2 && built.values()[1] == 2.0);
+
+           auto empty = cppgres::make_array(std::span<const double>());
+           result = result && _assert(empty.empty() && empty.ndim() == 0);
+
+           // Dimensions are validated before anything is allocated
+           std::vector<int> negative = {-1, -2};
+           exception_raised = false;
+           try {
+             cppgres::make_array(std::span<const double>(values), std::span<const int>(negative));
+           } catch (std::invalid_argument &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           std::vector<int> huge = {65536, 65536};
+           exception_raised = false;
+           try {
+             cppgres::make_array(std::span<const double>(values), std::span<const int>(huge));
+           } catch (std::length_error &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           return result;
+         }));
+
+add_test(expanded_array, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           cppgres::expanded_array<int64_t> a;
+           result = result && _assert(a.empty() && a.ndim() == 0);
+           for (int64_t i = 0; i < 1000; i++) {
+             a.push_back(i);
+           }
+           a.push_back(std::nullopt);
+           result = result && _assert(a.size() == 1001 && a.capacity() >= 1001);
+           result = result && _assert(a[999] == 999 && !a[1000].has_value());
+           a.set(0, 42);
+           a.set(1000, 1);
+           result = result && _assert(a[0] == 42 && a[1000] == 1);
+
+           auto texts = cppgres::expanded_array<std::string>(
+               spi.query<cppgres::datum>("select array['a', 'b']").begin()[0]);
+           texts.set(1, "c");
+           texts.push_back("d");
+           result = result && _assert(texts[1] == "c" && texts[2] == "d");
+
+           // State of an aggregate that appends in place
+           spi.execute(cppgres::fmt::format("create function expanded_array_append(int8[], int8) "
+                                            "returns int8[] language c as '{}'",
+                                            get_library_name()));
+           spi.execute("create aggregate expanded_array_agg(int8) "
+                       "(sfunc = expanded_array_append, stype = int8[], initcond = '{}')");
+           expanded_array_rw_states = 0;
+           auto agg = spi.query<cppgres::array<int64_t>>(
+                             "select expanded_array_agg(v) from generate_series(1, 100000) v")
+                          .begin()[0];
+           result = result && _assert(agg.size() == 100000 && agg.values()[99999] == 100000);
+           // Only the first transition gets the flat initial state
+           result = result && _assert(expanded_array_rw_states == 99999);
+
+           {
+             cppgres::internal_subtransaction sub(false);
+             bool exception_raised = false;
+             try {
+               spi.query<cppgres::datum>("select expanded_array_append('{1}'::int4[], 1)");
+             } catch (std::exception &) {
+               exception_raised = true;
+             }
+             result = result && _assert(exception_raised);
+           }
+
+           return result;
+         }));
+
+} // namespace tests
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <ranges>
+#include <string>
+
+#include "tests.hpp"
+
+namespace tests {
+
+postgres_function(datetime_bucket, ([](cppgres::interval width, cppgres::timestamptz ts) {
+                    auto w = width.duration();
+                    auto offset = ts.time_since_epoch() % w;
+                    return ts - (offset < offset.zero() ? offset + w : offset);
+                  }));
+
+postgres_function(datetime_days, ([](int32_t n) {
+                    return std::views::iota(0, n) | std::views::transform([](int32_t i) {
+                             return cppgres::interval{.days = i};
+                           });
+                  }));
+
+add_test(datetime_conversions, ([](test_case &) {
+           using namespace std::chrono_literals;
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute("set timezone to 'UTC'");
+
+           auto ts = spi.query<cppgres::timestamptz>("select '2000-01-02 00:00:01+00'::timestamptz")
+                         .begin()[0];
+           result = result && _assert(ts.time_since_epoch() == 24h + 1s);
+           result = result && _assert(cppgres::postgres_clock::to_sys(ts) ==
+                                      std::chrono::sys_days(std::chrono::year(2000) /
+                                                            std::chrono::January / 2) +
+                                          1s);
+
+           auto local =
+               spi.query<cppgres::timestamp>("select '1999-12-31 12:00:00'::timestamp").begin()[0];
+           result = result && _assert(local.time_since_epoch() == -12h);
+           auto day = std::chrono::floor<std::chrono::days>(local);
+           result = result && _assert(day.time_since_epoch() == std::chrono::days(-1));
+
+           auto d = spi.query<cppgres::date>("select '2000-03-01'::date").begin()[0];
+           result = result && _assert(d.time_since_epoch() == std::chrono::days(60));
+           auto inf = spi.query<cppgres::date>("select 'infinity'::date").begin()[0];
+           result = result && _assert(inf == cppgres::date::max());
+
+           auto t = spi.query<std::chrono::microseconds>("select '01:02:03.5'::time").begin()[0];
+           result = result && _assert(t == 1h + 2min + 3500ms);
+
+           auto i = spi.query<cppgres::interval>("select '1 month 2 days 00:00:03'::interval")
+                        .begin()[0];
+           result = result && _assert(i == cppgres::interval{.months = 1, .days = 2, .time = 3s});
+           result = result && _assert(i.duration() == std::chrono::days(32) + 3s);
+
+           // Into datums
+           auto text = spi.query<std::string>(
+                              "select $1::text || ' ' || $2::text || ' ' || $3::text || ' ' || "
+                              "$4::text",
+                              cppgres::timestamp(std::chrono::days(1) + 90min),
+                              cppgres::date(std::chrono::days(-1)), std::chrono::microseconds(1s),
+                              cppgres::interval{.days = 1, .time = 2h})
+                           .begin()[0];
+           result = result &&
+                    _assert(text == "2000-01-02 01:30:00 1999-12-31 00:00:01 1 day 02:00:00");
+
+           auto max = spi.query<bool>("select $1 = 'infinity'::timestamptz",
+                                      cppgres::timestamptz::max());
+           result = result && _assert(max.begin()[0]);
+
+           return result;
+         }));
+
+add_test(datetime_interval_set, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function datetime_days(int) returns setof interval language c as '{}'",
+               get_library_name()));
+           // Intervals are single values, not composites of their members
+           auto res = spi.query<std::string>(
+               "select string_agg(d::text, ', ') from datetime_days(3) d");
+           result = result && _assert(res.begin()[0] == "00:00:00, 1 day, 2 days");
+           return result;
+         }));
+
+add_test(datetime_bucketing, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute("set timezone to 'UTC'");
+           spi.execute(cppgres::fmt::format("create function datetime_bucket(interval, "
+                                            "timestamptz) returns timestamptz language c as '{}'",
+                                            get_library_name()));
+           auto buckets = spi.query<int64_t>(
+               "select count(distinct datetime_bucket('15 minutes', ts)) from "
+               "generate_series('2024-01-01'::timestamptz, '2024-01-01 23:59:59', '1 minute') ts");
+           result = result && _assert(buckets.begin()[0] == 96);
+
+           auto same = spi.query<bool>(
+               "select bool_and(datetime_bucket('1 hour', ts) = date_trunc('hour', ts)) from "
+               "generate_series('2024-01-01'::timestamptz, '2024-01-02', '7 minutes') ts");
+           result = result && _assert(same.begin()[0]);
+           return result;
+         }));
+
+} // namespace tests
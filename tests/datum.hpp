@@ -200,6 +200,77 @@ add_test(detoasted_varlena_tracks_detoast_context, ([](test_case &) {
            return result && _assert(saw_row);
          }));
 
+add_test(varlena_slices_and_chunks, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           spi.execute("create table varlena_slices (t text, b bytea)");
+           spi.execute("alter table varlena_slices alter column b set storage external");
+           spi.execute("insert into varlena_slices "
+                       "select repeat('abcdefghij', 100000), "
+                       "convert_to(repeat('0123456789', 100000), 'UTF8')");
+
+           for (auto [t, b] : spi.query<std::tuple<cppgres::text, cppgres::bytea>>(
+                    "select t, b from varlena_slices")) {
+             result = result && _assert(t.size() == 1000000);
+             result = result && _assert(t.slice(0, 5) == "abcde");
+             result = result && _assert(t.slice(999998, 10) == "ij");
+             result = result && _assert(t.slice(2000000, 10).empty());
+             result = result && _assert(!t.is_detoasted());
+
+             result = result && _assert(b.size() == 1000000);
+             auto bytes = b.slice(13, 3);
+             result = result && _assert(bytes.size() == 3 && bytes[0] == std::byte('3') &&
+                                        bytes[2] == std::byte('5'));
+             result = result && _assert(!b.is_detoasted());
+
+             // Fetched window by window
+             std::size_t total = 0;
+             std::size_t windows = 0;
+             for (auto window : b.chunks(65536)) {
+               result = result && _assert(window.size() <= 65536);
+               result = result && _assert(window[0] == std::byte('0' + total % 10));
+               total += window.size();
+               windows++;
+             }
+             result = result && _assert(total == 1000000);
+             result = result && _assert(windows == 16);
+             result = result && _assert(!b.is_detoasted());
+
+             // Compressed values are detoasted once
+             total = 0;
+             for (auto window : t.chunks(300000)) {
+               total += window.size();
+             }
+             result = result && _assert(total == 1000000);
+           }
+
+           // Reading stops once the memory of the value is gone
+           {
+             auto ctx = cppgres::memory_context(std::move(cppgres::alloc_set_memory_context()));
+             ::text *value;
+             {
+               cppgres::memory_context_scope scope(ctx);
+               value = ::cstring_to_text("0123456789");
+             }
+             cppgres::text v(cppgres::datum(PointerGetDatum(value)), ctx);
+             auto reader = v.chunks(4);
+             auto it = reader.begin();
+             result = result && _assert((*it).size() == 4);
+             ctx.reset();
+
+             bool exception_raised = false;
+             try {
+               ++it;
+             } catch (cppgres::pointer_gone_exception &) {
+               exception_raised = true;
+             }
+             result = result && _assert(exception_raised);
+           }
+
+           return result;
+         }));
+
 add_test(eoh_smoke, ([](test_case &e) {
            bool result = true;
 
@@ -14,6 +14,35 @@ add_test(catch_error, ([](test_case &) {
            return false;
          }));
 
+add_test(ffi_guard_region, ([](test_case &) {
+           bool result = true;
+           auto *exception_stack = ::PG_exception_stack;
+           auto *context_stack = ::error_context_stack;
+
+           auto oid = cppgres::ffi_guard_region([] {
+             ::Oid role = ::get_role_oid("pg_monitor", false);
+             return ::get_role_oid(::GetUserNameFromId(role, false), false);
+           });
+           result = result &&
+                    _assert(oid == cppgres::ffi_guard{::get_role_oid}("pg_monitor", false));
+
+           bool caught = false;
+           try {
+             cppgres::ffi_guard_region([] {
+               ::get_role_oid("pg_monitor", false);
+               ::get_role_oid("this_role_does_not_exist", false);
+             });
+           } catch (cppgres::pg_exception &e) {
+             caught = true;
+           }
+           result = result && _assert(caught);
+
+           // Handlers are restored after both normal and erroneous exit
+           result = result && _assert(::PG_exception_stack == exception_stack);
+           result = result && _assert(::error_context_stack == context_stack);
+           return result;
+         }));
+
 postgres_function(raise_exception,
                   ([]() -> bool { throw std::runtime_error("raised an exception"); }));
 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "tests.hpp"
+
+namespace tests {
+
+add_test(expression_eval, ([](test_case &) {
+           bool result = true;
+
+           cppgres::expression<int32_t, int32_t, int32_t> add("$1 * 2 + $2");
+           result = result && _assert(add.result_type() == cppgres::type{.oid = INT4OID});
+           int64_t sum = 0;
+           for (int32_t i = 0; i < 1000; i++) {
+             sum += add(i, 1);
+           }
+           result = result && _assert(sum == 1000000);
+
+           // Bulk evaluation
+           cppgres::expression<bool, std::string> filter("length($1) > 2");
+           std::vector<std::string> inputs = {"a", "abc", "abcd"};
+           result = result && _assert(filter.transform(inputs) == std::vector<bool>({false, true,
+                                                                                      true}));
+
+           std::vector<std::tuple<int32_t, int32_t>> pairs = {{1, 2}, {3, 4}};
+           std::vector<int32_t> added;
+           add.transform(pairs, std::back_inserter(added));
+           result = result && _assert(added == std::vector<int32_t>({4, 10}));
+
+           // Nulls
+           cppgres::expression<std::optional<int32_t>, std::optional<int32_t>> inc("$1 + 1");
+           result = result && _assert(inc(1) == 2);
+           result = result && _assert(!inc(std::nullopt).has_value());
+
+           // JIT disabled explicitly
+           cppgres::expression<std::string, std::string> upper("upper($1)", false);
+           result = result && _assert(upper("test") == "TEST");
+
+           return result;
+         }));
+
+add_test(expression_errors, ([](test_case &) {
+           bool result = true;
+
+           for (auto text : {"1) from pg_class where (true", "(select 1)", "count(*)",
+                             "generate_series(1, 2)"}) {
+             bool exception_raised = false;
+             try {
+               cppgres::expression<int64_t> e(text);
+             } catch (std::invalid_argument &e) {
+               exception_raised = true;
+             }
+             result = result && _assert(exception_raised);
+           }
+
+           {
+             bool exception_raised = false;
+             try {
+               cppgres::expression<std::string, int32_t> e("$1 + 1");
+             } catch (std::runtime_error &e) {
+               exception_raised = std::string_view(e.what()) ==
+                                  "expected expression of type text, got integer";
+             }
+             result = result && _assert(exception_raised);
+           }
+
+           {
+             cppgres::internal_subtransaction sub(false);
+             bool exception_raised = false;
+             try {
+               cppgres::expression<int32_t> e("1 +");
+             } catch (cppgres::pg_exception &e) {
+               exception_raised = true;
+             }
+             result = result && _assert(exception_raised);
+           }
+
+           return result;
+         }));
+
+} // namespace tests
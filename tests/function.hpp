@@ -209,6 +209,40 @@ add_test(function_call, ([](test_case &) {
            return result;
          }));
 
+add_test(function_call_frame_reuse, ([](test_case &) {
+           bool result = true;
+
+           cppgres::function<int32_t, std::string> f("length");
+           for (int i = 0; i < 100; i++) {
+             result = result && _assert(f(std::string(i, 'a')) == i);
+           }
+
+           // Copies share the call frame
+           auto g = f;
+           result = result && _assert(g("test") == 4);
+
+           // Bulk invocation
+           std::vector<std::string> inputs = {"a", "bb", "ccc"};
+           auto lengths = f.transform(inputs);
+           result = result && _assert(lengths == std::vector<int32_t>({1, 2, 3}));
+
+           cppgres::function<std::string, std::string, std::string> concat("textcat");
+           std::vector<std::tuple<std::string, std::string>> pairs = {{"a", "b"}, {"c", "d"}};
+           std::vector<std::string> concatenated;
+           concat.transform(pairs, std::back_inserter(concatenated));
+           result = result && _assert(concatenated == std::vector<std::string>({"ab", "cd"}));
+
+           // The call frame is resolved again once its memory context is reset
+           cppgres::alloc_set_memory_context ctx;
+           f.cache_in(cppgres::memory_context(ctx));
+           result = result && _assert(f("test") == 4);
+           ctx.reset();
+           result = result && _assert(f("hello") == 5);
+           f.cache_in(cppgres::memory_context());
+
+           return result;
+         }));
+
 add_test(function_oid_rejects_extra_args, ([](test_case &) {
            bool result = true;
            cppgres::spi_executor spi;
@@ -277,6 +311,109 @@ add_test(postgres_function_rejects_too_few_fmgr_args, ([](test_case &) {
            return result;
          }));
 
+struct call_plan_cached_state {
+  static inline void *first_plan = nullptr;
+};
+
+postgres_function(call_plan_cached, ([](int32_t i) {
+                    ::FunctionCallInfo fcinfo = *cppgres::current_postgres_function::call_info();
+                    auto *plan = fcinfo->flinfo->fn_extra;
+                    if (i == 1) {
+                      call_plan_cached_state::first_plan = plan;
+                    }
+                    // the plan resolved by the first call is the one every later call uses
+                    return plan != nullptr && plan == call_plan_cached_state::first_plan;
+                  }));
+
+add_test(postgres_function_call_plan_cached, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function call_plan_cached(int) returns bool language c as '{}'",
+               get_library_name()));
+
+           call_plan_cached_state::first_plan = nullptr;
+           auto cached = spi.query<bool>(
+               "select bool_and(call_plan_cached(i)) from generate_series(1,100) i");
+           result = result && _assert(cached.begin()[0]);
+           result = result && _assert(call_plan_cached_state::first_plan != nullptr);
+
+           return result;
+         }));
+
+postgres_function(lazy_arg, ([](bool touch, cppgres::lazy<std::optional<std::string_view>> s) {
+                    if (!touch) {
+                      // nothing has been converted (or detoasted) yet
+                      return s.converted() ? -2 : -1;
+                    }
+                    return s->has_value() ? static_cast<int32_t>((*s)->size()) : 0;
+                  }));
+
+add_test(postgres_function_lazy_arg, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function lazy_arg(bool, text) returns int language c as '{}'",
+               get_library_name()));
+           spi.execute("create table lazy_arg_t (t text)");
+           spi.execute("insert into lazy_arg_t values (repeat('x', 1000000))");
+
+           auto untouched = spi.query<int32_t>("select lazy_arg(false, t) from lazy_arg_t");
+           result = result && _assert(untouched.begin()[0] == -1);
+
+           auto touched = spi.query<int32_t>("select lazy_arg(true, t) from lazy_arg_t");
+           result = result && _assert(touched.begin()[0] == 1000000);
+
+           auto null = spi.query<int32_t>("select lazy_arg(true, null)");
+           result = result && _assert(null.begin()[0] == 0);
+
+           return result;
+         }));
+
+postgres_function(csv_builder, ([](int32_t rows) {
+                    cppgres::text_builder csv;
+                    for (int32_t i = 0; i < rows; i++) {
+                      cppgres::fmt::format_to(std::back_inserter(csv), "{},{}\n", i, i * i);
+                    }
+                    return csv;
+                  }));
+
+add_test(varlena_builder, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function csv_builder(int) returns text language c as '{}'",
+               get_library_name()));
+           auto csv = spi.query<std::string>("select csv_builder(3)");
+           result = result && _assert(csv.begin()[0] == "0,0\n1,1\n2,4\n");
+           auto len = spi.query<int32_t>("select length(csv_builder(100000))");
+           result = result && _assert(len.begin()[0] > 1000000);
+
+           cppgres::bytea_builder b(1);
+           b.append(std::string_view("ab")).push_back('c');
+           result = result && _assert(b.size() == 3 && b.capacity() >= 3);
+           cppgres::byte_array bytes = b.value();
+           result = result && _assert(bytes.size() == 3 && bytes[2] == std::byte('c'));
+           // the datum is the builder's buffer
+           result = result && _assert(DatumGetPointer(b.get_datum()) ==
+                                      reinterpret_cast<char *>(b.data()) - VARHDRSZ);
+           // and its header is kept up to date as the value is written
+           b.push_back('d');
+           result = result && _assert(VARSIZE_ANY_EXHDR(DatumGetPointer(b.get_datum())) == 4);
+
+           auto moved = std::move(b);
+           result = result && _assert(moved.view() == "abcd");
+           bool exception_raised = false;
+           try {
+             b.get_datum();
+           } catch (std::logic_error &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           return result;
+         }));
+
 // Function that takes a function
 postgres_function(function_arg, ([](cppgres::function<std::int32_t, std::string_view> f,
                                     std::string_view s) { return f(s); }));
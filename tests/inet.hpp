@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "tests.hpp"
+
+namespace tests {
+
+postgres_function(inet_in_network,
+                  ([](cppgres::cidr network, cppgres::inet address) {
+                    return network.contains(address);
+                  }));
+
+add_test(inet_conversions, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           auto host = spi.query<cppgres::inet>("select '192.168.1.5/24'::inet").begin()[0];
+           result = result && _assert(host.family() == cppgres::inet_family::ipv4);
+           result = result && _assert(host.bits() == 24);
+           auto address = host.address();
+           result = result && _assert(address.size() == 4 && address[0] == std::byte{192} &&
+                                      address[3] == std::byte{5});
+
+           auto loopback = spi.query<cppgres::inet>("select '::1'::inet").begin()[0];
+           result = result && _assert(loopback.family() == cppgres::inet_family::ipv6);
+           result = result && _assert(loopback.bits() == 128 && loopback.address().size() == 16);
+           result = result && _assert(loopback.address()[15] == std::byte{1});
+
+           // Values read from a table have a short header and are read in place
+           spi.execute("create table inet_stored (i inet)");
+           spi.execute("insert into inet_stored values ('192.168.1.5/24')");
+           auto stored = spi.query<cppgres::inet>("select i from inet_stored").begin()[0];
+           result = result && _assert(stored.bits() == 24 && stored.address()[3] == std::byte{5});
+           result = result && _assert(!stored.is_detoasted());
+
+           auto network = spi.query<cppgres::cidr>("select '10.0.0.0/8'::cidr").begin()[0];
+           auto inside = spi.query<cppgres::inet>("select '10.1.2.3'::inet").begin()[0];
+           auto outside = spi.query<cppgres::inet>("select '11.0.0.1'::inet").begin()[0];
+           result = result && _assert(network.contains(inside) && !network.contains(outside));
+           result = result && _assert(!network.contains(loopback));
+
+           std::array<std::byte, 4> bytes = {std::byte{10}, std::byte{0}, std::byte{0},
+                                             std::byte{1}};
+           auto text = spi.query<std::string>(
+                              "select $1::text || ' ' || $2::text",
+                              cppgres::inet(cppgres::inet_family::ipv4, bytes, 32),
+                              cppgres::cidr(cppgres::inet_family::ipv4, bytes, 32))
+                           .begin()[0];
+           result = result && _assert(text == "10.0.0.1 10.0.0.1/32");
+
+           bool exception_raised = false;
+           try {
+             cppgres::cidr(cppgres::inet_family::ipv4, bytes, 8);
+           } catch (std::invalid_argument &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           exception_raised = false;
+           try {
+             cppgres::inet(cppgres::inet_family::ipv6, bytes, 8);
+           } catch (std::invalid_argument &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           // Same results as `>>=`
+           spi.execute(cppgres::fmt::format(
+               "create function inet_in_network(cidr, inet) returns bool language c as '{}'",
+               get_library_name()));
+           auto same = spi.query<bool>(
+               "select bool_and(inet_in_network(n, a) = (n >>= a)) from "
+               "(values ('10.0.0.0/8'::cidr), ('10.1.0.0/16'), ('10.1.2.0/23'), ('::/0'), "
+               "('192.168.1.0/24'), ('0.0.0.0/0')) n(n), "
+               "(values ('10.1.2.3'::inet), ('10.1.3.3'), ('192.168.1.77'), ('::1'), "
+               "('10.2.0.1/8'), ('10.1.0.0/16')) a(a)");
+           result = result && _assert(same.begin()[0]);
+
+           return result;
+         }));
+
+} // namespace tests
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <limits>
+#include <map>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tests.hpp"
+
+namespace tests {
+
+postgres_function(jsonb_order_total, ([](cppgres::jsonb order) {
+                    int64_t total = 0;
+                    for (auto item : order.root()["items"].elements()) {
+                      total += item["price"].as_numeric()->to_scaled<int64_t>(2) *
+                               item["quantity"].as_numeric()->to_integer<int64_t>();
+                    }
+                    return cppgres::numeric::from_scaled(total, 2);
+                  }));
+
+#if BOOST_PFR_CORE_NAME_ENABLED
+struct jsonb_test_item {
+  std::string name;
+  int64_t quantity;
+  std::optional<double> price;
+  std::vector<std::string> tags;
+  std::map<std::string, bool> flags;
+  std::size_t tag_count;
+};
+
+postgres_function(jsonb_build_item, ([](int32_t i) {
+                    cppgres::jsonb_builder builder;
+                    return builder.build(jsonb_test_item{
+                        .name = cppgres::fmt::format("item{}", i),
+                        .quantity = i,
+                        .price = i % 2 == 0 ? std::optional<double>(i * 1.5) : std::nullopt,
+                        .tags = {"a", "b"},
+                        .flags = {{"new", i == 1}},
+                        .tag_count = 2});
+                  }));
+#endif
+
+add_test(jsonb_navigation, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           auto doc = spi.query<cppgres::jsonb>(
+                             R"(select '{"name": "test", "active": true, "none": null,
+                                         "count": 42.5, "tags": ["a", "b", "c"],
+                                         "nested": {"key": "value"}}'::jsonb)")
+                          .begin()[0];
+           auto root = doc.root();
+           result = result && _assert(root.is_object() && root.size() == 6);
+           result = result && _assert(root["name"].as_string() == "test");
+           result = result && _assert(root["active"].as_bool() == true);
+           result = result && _assert(root["none"].is_null());
+           result = result && _assert(root["count"].as_numeric()->to_scaled<int64_t>(1) == 425);
+           result = result && _assert(root["nested"]["key"].as_string() == "value");
+           result = result && _assert(!root.get("missing").has_value());
+           result = result && _assert(!root["name"].as_bool().has_value());
+
+           auto tags = root["tags"];
+           result = result && _assert(tags.is_array() && tags.size() == 3);
+           result = result && _assert(tags[1].as_string() == "b");
+           result = result && _assert(!tags.get(3).has_value());
+           std::string joined;
+           for (auto tag : tags.elements()) {
+             joined += *tag.as_string();
+           }
+           result = result && _assert(joined == "abc");
+
+           // Members are ordered by key length first
+           std::string keys;
+           for (auto [key, value] : root.members()) {
+             keys += std::string(key) + ",";
+           }
+           result = result && _assert(keys == "name,none,tags,count,active,nested,");
+
+           // Iterators stay valid after the range they were obtained from is gone
+           auto it = root["tags"].elements().begin();
+           auto end = root["tags"].elements().end();
+           ++it;
+           result = result && _assert(it != end && (*it).as_string() == "b");
+           auto member = root.members().begin();
+           result = result && _assert((*member).first == "name");
+
+           bool exception_raised = false;
+           try {
+             root["tags"]["name"];
+           } catch (std::out_of_range &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           auto scalar = spi.query<cppgres::jsonb>("select '\"text\"'::jsonb").begin()[0];
+           result = result && _assert(scalar.root().as_string() == "text");
+
+           // Large objects and arrays store offsets every few entries
+           auto big =
+               spi.query<cppgres::jsonb>(
+                      "select jsonb_object_agg('key' || i, i) from generate_series(1, 100) i")
+                   .begin()[0];
+           bool all_found = true;
+           for (int i = 1; i <= 100; i++) {
+             auto v = big.get(cppgres::fmt::format("key{}", i));
+             all_found = all_found && v.has_value() && v->as_numeric()->to_integer<int>() == i;
+           }
+           result = result && _assert(all_found);
+           int members = 0;
+           for (auto [key, value] : big.root().members()) {
+             auto n = std::stoi(std::string(key.substr(3)));
+             members += value.as_numeric()->to_integer<int>() == n;
+           }
+           result = result && _assert(members == 100);
+
+           return result;
+         }));
+
+add_test(jsonb_toasted, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute("create table jsonb_toasted (j jsonb)");
+           spi.execute("alter table jsonb_toasted alter column j set storage external");
+           spi.execute("insert into jsonb_toasted "
+                       "select jsonb_object_agg('key' || i, i) from generate_series(1, 10000) i");
+
+           // Stored out of line, the value is detoasted before it is read
+           auto doc = spi.query<cppgres::jsonb>("select j from jsonb_toasted").begin()[0];
+           result = result && _assert(!doc.is_detoasted());
+           auto root = doc.root();
+           result = result && _assert(root.is_object() && root.size() == 10000);
+           result = result && _assert(root["key5000"].as_numeric()->to_integer<int>() == 5000);
+           result = result && _assert(doc.is_detoasted());
+           return result;
+         }));
+
+add_test(jsonb_function, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function jsonb_order_total(jsonb) returns numeric language c as '{}'",
+               get_library_name()));
+           auto total = spi.query<std::string>(
+               R"(select jsonb_order_total('{"items": [{"price": 1.25, "quantity": 2},
+                                                       {"price": 10, "quantity": 1}]}')::text)");
+           result = result && _assert(total.begin()[0] == "12.50");
+           return result;
+         }));
+
+add_test(jsonb_building, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           cppgres::jsonb_builder builder;
+
+           auto text = [&](cppgres::jsonb &&j) {
+             return spi.query<std::string>("select $1::text", std::move(j)).begin()[0];
+           };
+
+           result = result && _assert(text(builder.build(42)) == "42");
+           result = result && _assert(text(builder.build("text")) == "\"text\"");
+           constexpr auto size_max = std::numeric_limits<std::size_t>::max();
+           result = result && _assert(text(builder.build(size_max)) == std::to_string(size_max));
+           result = result && _assert(text(builder.build(uint32_t{7})) == "7");
+           result = result && _assert(text(builder.build(int8_t{-5})) == "-5");
+           result = result && _assert(text(builder.build(std::nullopt)) == "null");
+           result = result &&
+                    _assert(text(builder.build(std::numeric_limits<double>::infinity())) ==
+                            "\"Infinity\"");
+
+           std::vector<std::optional<int32_t>> values = {1, std::nullopt, 3};
+           result = result && _assert(text(builder.build(values)) == "[1, null, 3]");
+
+           // Strings produced by a view are copied before they go away
+           auto strings = std::views::iota(1, 4) |
+                          std::views::transform([](int i) { return std::to_string(i); });
+           result = result && _assert(text(builder.build(strings)) == R"(["1", "2", "3"])");
+
+           // Keys are sorted the way jsonb sorts them and the last duplicate key wins
+           std::vector<std::pair<std::string, int32_t>> pairs = {{"bb", 1}, {"a", 2}, {"bb", 3}};
+           result = result && _assert(text(builder.build(pairs)) == R"({"a": 2, "bb": 3})");
+
+           // Built values are equal to the ones Postgres makes
+           std::map<std::string, std::vector<double>> m = {{"x", {0.5, 2}}, {"y", {}}};
+           auto same = spi.query<bool>(R"(select $1 = '{"x": [0.5, 2], "y": []}'::jsonb)",
+                                       builder.build(m));
+           result = result && _assert(same.begin()[0]);
+
+#if BOOST_PFR_CORE_NAME_ENABLED
+           spi.execute(cppgres::fmt::format(
+               "create function jsonb_build_item(int4) returns jsonb language c as '{}'",
+               get_library_name()));
+           auto item = spi.query<std::string>("select jsonb_build_item(2)::text").begin()[0];
+           result = result && _assert(item == R"({"name": "item2", "tags": ["a", "b"], )"
+                                              R"("flags": {"new": false}, "price": 3, )"
+                                              R"("quantity": 2, "tag_count": 2})");
+           auto matches = spi.query<int64_t>(
+               "select count(*) from generate_series(1, 10000) i where "
+               "jsonb_build_item(i) @> jsonb_build_object('quantity', i, 'name', 'item' || i)");
+           result = result && _assert(matches.begin()[0] == 10000);
+#endif
+
+           return result;
+         }));
+
+} // namespace tests
@@ -1,12 +1,26 @@
 #pragma once
 
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
 #include <stdexcept>
 #include <type_traits>
+#include <unordered_set>
+#include <vector>
 
 #include "tests.hpp"
 
 namespace tests {
 
+postgres_function(pmr_distinct_count, ([](cppgres::array<int64_t> values) {
+                    cppgres::memory_context_bump_resource resource;
+                    std::pmr::unordered_set<int64_t> seen(&resource);
+                    for (auto v : values.values()) {
+                      seen.insert(v);
+                    }
+                    return static_cast<int64_t>(seen.size());
+                  }));
+
 static_assert(!std::copy_constructible<cppgres::alloc_set_memory_context>);
 static_assert(!std::is_copy_assignable_v<cppgres::alloc_set_memory_context>);
 static_assert(std::move_constructible<cppgres::alloc_set_memory_context>);
@@ -161,6 +175,51 @@ add_test(tracking_memory_context_copy_shares_reset_state, ([](test_case &) {
            return result;
          }));
 
+add_test(memory_context_generation, ([](test_case &) {
+           bool result = true;
+           auto callbacks = [](::MemoryContext ctx) {
+             int n = 0;
+             for (auto *cb = ctx->reset_cbs; cb != nullptr; cb = cb->next) {
+               n++;
+             }
+             return n;
+           };
+
+           cppgres::alloc_set_memory_context ctx;
+           cppgres::memory_context_generation g1(ctx);
+           cppgres::memory_context_generation g2(ctx);
+           result = result && _assert(g1.valid() && g2.valid());
+           // one callback per context, not per tracked value
+           result = result && _assert(callbacks(ctx) == 1);
+
+           ctx.reset();
+           result = result && _assert(!g1.valid() && !g2.valid());
+
+           cppgres::memory_context_generation g3(ctx);
+           result = result && _assert(g3.valid());
+           result = result && _assert(callbacks(ctx) == 1);
+
+           // Counters of deleted contexts are recycled, values tracked before stay invalid
+           std::optional<cppgres::memory_context_generation> g4;
+           {
+             cppgres::alloc_set_memory_context other;
+             g4.emplace(other);
+           }
+           cppgres::alloc_set_memory_context next;
+           cppgres::memory_context_generation g5(next);
+           result = result && _assert(!g4->valid() && g5.valid());
+
+           // Untracked values don't register anything
+           int top_callbacks = callbacks(TopMemoryContext);
+           auto nd = cppgres::nullable_datum(PointerGetDatum(::cstring_to_text("test")));
+           auto s = cppgres::from_nullable_datum<cppgres::text>(nd, TEXTOID);
+           result = result && _assert(std::string_view(s) == "test");
+           result = result && _assert(callbacks(TopMemoryContext) == top_callbacks);
+           result = result && _assert(cppgres::memory_context_generation().valid());
+
+           return result;
+         }));
+
 add_test(executing_within_memory_context, ([](test_case &) {
            bool result = true;
            cppgres::alloc_set_memory_context mctx;
@@ -178,6 +237,90 @@ add_test(executing_within_memory_context, ([](test_case &) {
            }
            result = result && _assert(mctx != cppgres::always_current_memory_context());
 
+           return result;
+         }));
+
+add_test(memory_context_resource, ([](test_case &) {
+           bool result = true;
+
+           cppgres::alloc_set_memory_context ctx;
+           cppgres::memory_context_resource resource{cppgres::memory_context(ctx)};
+           std::pmr::vector<int64_t> v(&resource);
+           for (int64_t i = 0; i < 1000; i++) {
+             v.push_back(i);
+           }
+           result = result && _assert(v[999] == 999);
+           result = result && _assert(cppgres::memory_context::for_pointer(v.data()) == ctx);
+
+           cppgres::memory_context_resource same{cppgres::memory_context(ctx)};
+           cppgres::memory_context_resource top(cppgres::top_memory_context());
+           result = result && _assert(resource.is_equal(same) && !resource.is_equal(top));
+
+           // Over-aligned allocations
+           auto *p = resource.allocate(64, 64);
+           result = result && _assert(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+
+           // Freed explicitly in `TopMemoryContext`
+           auto before = ::MemoryContextMemAllocated(::TopMemoryContext, true);
+           {
+             std::pmr::vector<int64_t> w(&top);
+             w.resize(1024 * 1024);
+           }
+           result = result && _assert(::MemoryContextMemAllocated(::TopMemoryContext, true) <
+                                      before + 1024 * 1024 * sizeof(int64_t));
+
+           // Over-aligned ones included
+           before = ::MemoryContextMemAllocated(::TopMemoryContext, true);
+           auto *q = top.allocate(1024 * 1024, 64);
+           result = result && _assert(reinterpret_cast<std::uintptr_t>(q) % 64 == 0);
+           top.deallocate(q, 1024 * 1024, 64);
+           result = result &&
+                    _assert(::MemoryContextMemAllocated(::TopMemoryContext, true) < before + 1024);
+
+           return result;
+         }));
+
+add_test(memory_context_bump_resource, ([](test_case &) {
+           bool result = true;
+
+           cppgres::alloc_set_memory_context ctx;
+           cppgres::memory_context_bump_resource resource(cppgres::memory_context(ctx), 1024);
+           auto *a = static_cast<std::byte *>(resource.allocate(10, 1));
+           auto *b = static_cast<std::byte *>(resource.allocate(10, 1));
+           result = result && _assert(b == a + 10);
+           auto *c = resource.allocate(8, 64);
+           result = result && _assert(reinterpret_cast<std::uintptr_t>(c) % 64 == 0);
+
+           // Larger than a block
+           auto *big = static_cast<std::byte *>(resource.allocate(1024 * 1024, 8));
+           big[1024 * 1024 - 1] = std::byte{1};
+
+           {
+             std::pmr::unordered_set<int64_t> set(&resource);
+             for (int64_t i = 0; i < 10000; i++) {
+               set.insert(i);
+             }
+             result = result && _assert(set.size() == 10000 && set.contains(9999));
+           }
+
+           // Resetting the memory context frees the blocks and the resource starts over
+           ctx.reset();
+           std::pmr::vector<int64_t> v(&resource);
+           v.assign(100, 1);
+           result = result && _assert(v.back() == 1);
+
+           resource.release();
+           result = result && _assert(::MemoryContextMemAllocated(ctx, false) <
+                                      static_cast<::Size>(1024 * 1024));
+
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function pmr_distinct_count(int8[]) returns int8 language c as '{}'",
+               get_library_name()));
+           auto count = spi.query<int64_t>(
+               "select pmr_distinct_count(array_agg(i % 1000)) from generate_series(1, 100000) i");
+           result = result && _assert(count.begin()[0] == 1000);
+
            return result;
          }));
 } // namespace tests
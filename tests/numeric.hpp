@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "tests.hpp"
+
+namespace tests {
+
+struct numeric_sum_test {
+  __int128 sum = 0;
+
+  void update(cppgres::numeric v) { sum += v.to_scaled<__int128>(2); }
+  cppgres::numeric finalize() const { return cppgres::numeric::from_scaled(sum, 2); }
+};
+
+declare_aggregate(numeric_sum, numeric_sum_test, cppgres::numeric);
+
+add_test(numeric_conversions, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           auto n = spi.query<cppgres::numeric>("select 1234567.895::numeric").begin()[0];
+           result = result && _assert(n.scale() == 3 && !n.is_negative());
+           result = result && _assert(n.to_scaled<int64_t>(3) == 1234567895);
+           result = result && _assert(n.to_scaled<int64_t>(2) == 123456790);
+           result = result && _assert(n.to_integer<int32_t>() == 1234568);
+           result = result && _assert(n.to_double() == 1234567.895);
+
+           auto neg = spi.query<cppgres::numeric>("select -0.00015::numeric").begin()[0];
+           result = result && _assert(neg.is_negative());
+           result = result && _assert(neg.to_scaled<int64_t>(4) == -2);
+           result = result && _assert(neg.to_scaled<int64_t>(3) == 0);
+
+           auto min = spi.query<cppgres::numeric>("select -9223372036854775808::numeric")
+                          .begin()[0];
+           result = result && _assert(min.to_integer<int64_t>() == INT64_MIN);
+
+           // Round trips through Postgres' text representation
+           auto text = [&](cppgres::numeric &&v) {
+             return spi.query<std::string>("select $1::text", std::move(v)).begin()[0];
+           };
+           result = result && _assert(text(cppgres::numeric::from_scaled<int64_t>(-12345, 2)) ==
+                                      "-123.45");
+           result = result && _assert(text(cppgres::numeric::from_scaled<int64_t>(5, 6)) ==
+                                      "0.000005");
+           result = result && _assert(text(cppgres::numeric::from_scaled<int64_t>(0, 2)) == "0.00");
+           result = result && _assert(text(cppgres::numeric::from_integer<int64_t>(100000000)) ==
+                                      "100000000");
+           __int128 big = static_cast<__int128>(INT64_MAX) * 1000;
+           result = result && _assert(text(cppgres::numeric::from_scaled(big, 100)) ==
+                                      "0." + std::string(78, '0') + "9223372036854775807000");
+           result = result && _assert(text(cppgres::numeric::from_double(0.25)) == "0.25");
+
+           // Values built here are equal to the ones Postgres makes
+           auto same = spi.query<bool>("select $1 = 123.45 and $1::text = '123.45'",
+                                       cppgres::numeric::from_scaled<int64_t>(12345, 2));
+           result = result && _assert(same.begin()[0]);
+
+           // Arithmetic through Postgres
+           auto a = cppgres::numeric::from_scaled<int64_t>(15, 1);
+           auto b = cppgres::numeric::from_integer<int64_t>(2);
+           result = result && _assert((a * b).to_integer<int64_t>() == 3);
+           result = result && _assert(text(a / b) == "0.75000000000000000000");
+           result = result && _assert(!(a > b) && a < b && a + a > b);
+           result = result && _assert(a - a == cppgres::numeric::from_integer<int64_t>(0));
+
+           // Long and very large or small values
+           auto third = spi.query<cppgres::numeric>("select 1::numeric(1000, 400) / 3").begin()[0];
+           result = result && _assert(std::abs(third.to_double() - 1.0 / 3) < 1e-16);
+           auto tiny = spi.query<cppgres::numeric>("select 1e-310::numeric").begin()[0];
+           result = result && _assert(tiny.to_double() > 0 &&
+                                      std::abs(tiny.to_double() - 1e-310) < 1e-320);
+           auto huge = spi.query<cppgres::numeric>("select 1e400::numeric").begin()[0];
+           result = result && _assert(std::isinf(huge.to_double()));
+
+           auto small = spi.query<cppgres::numeric>("select 10001::numeric").begin()[0];
+           result = result && _assert(small.to_integer<int16_t>() == 10001);
+           static_assert(!cppgres::numeric_fixed_point_rep<int8_t>);
+
+           auto special = spi.query<cppgres::numeric>("select 'NaN'::numeric").begin()[0];
+           result = result && _assert(special.is_nan() && std::isnan(special.to_double()));
+
+           bool exception_raised = false;
+           try {
+             special.to_integer<int64_t>();
+           } catch (std::domain_error &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           exception_raised = false;
+           try {
+             spi.query<cppgres::numeric>("select 1e30::numeric").begin()[0].to_integer<int64_t>();
+           } catch (std::overflow_error &) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           return result;
+         }));
+
+add_test(numeric_toasted, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute("create table numeric_toasted (n numeric)");
+           spi.execute("alter table numeric_toasted alter column n set storage external");
+           spi.execute("insert into numeric_toasted values (-repeat('9', 5000)::numeric)");
+
+           // Stored out of line, the value is detoasted before it is read
+           auto n = spi.query<cppgres::numeric>("select n from numeric_toasted").begin()[0];
+           result = result && _assert(n.is_negative() && n.scale() == 0);
+           result = result && _assert(n.to_double() == -std::numeric_limits<double>::infinity());
+           result = result && _assert(n.is_detoasted());
+           return result;
+         }));
+
+add_test(numeric_aggregate, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function numeric_sum_sfunc(internal, numeric) returns internal "
+               "language c as '{0}';"
+               "create function numeric_sum_ffunc(internal) returns numeric language c as '{0}'",
+               get_library_name()));
+           spi.execute("create aggregate numeric_sum(numeric) (sfunc = numeric_sum_sfunc, "
+                       "finalfunc = numeric_sum_ffunc, stype = internal)");
+           spi.execute("create table numeric_sum_values as "
+                       "select (v / 100.0)::numeric(12, 2) as v from generate_series(1, 100000) v");
+           auto same = spi.query<bool>(
+               "select numeric_sum(v) = sum(v) from numeric_sum_values");
+           result = result && _assert(same.begin()[0]);
+           return result;
+         }));
+
+} // namespace tests
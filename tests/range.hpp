@@ -0,0 +1,184 @@
+#pragma once
+
+#include <chrono>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+
+namespace tests {
+
+postgres_function(range_overlaps_cpp, ([](cppgres::range<int64_t> a, cppgres::range<int64_t> b) {
+                    return a.overlaps(b);
+                  }));
+
+postgres_function(range_contains_cpp, ([](cppgres::range<int64_t> a, cppgres::range<int64_t> b) {
+                    return a.contains(b);
+                  }));
+
+postgres_function(range_contains_value_cpp, ([](cppgres::range<int64_t> r, int64_t v) {
+                    return r.contains(v);
+                  }));
+
+postgres_function(range_splits, ([](int64_t n) {
+                    return std::views::iota(int64_t(0), n) | std::views::transform([](int64_t i) {
+                             return cppgres::range<int64_t>{.lower = {i * 10, true},
+                                                            .upper = {i * 10 + 10, false}};
+                           });
+                  }));
+
+add_test(range_conversions, ([](test_case &) {
+           using namespace std::chrono_literals;
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute("set timezone to 'UTC'");
+
+           auto r = spi.query<cppgres::range<int64_t>>("select int8range(1, 10)").begin()[0];
+           result = result && _assert(!r.empty && r.type_oid == INT8RANGEOID);
+           result = result && _assert(r.lower.value == 1 && r.lower.inclusive);
+           result = result && _assert(r.upper.value == 10 && !r.upper.inclusive);
+           result = result && _assert(r.contains(1) && r.contains(9) && !r.contains(10));
+
+           // Discrete ranges come canonicalized
+           auto closed = spi.query<cppgres::range<int64_t>>("select '[1,5]'::int8range").begin()[0];
+           result = result && _assert(closed.upper.value == 6 && !closed.upper.inclusive);
+
+           auto empty = spi.query<cppgres::range<int64_t>>("select 'empty'::int8range").begin()[0];
+           result = result && _assert(empty.empty && !empty.contains(1));
+           result = result && _assert(r.contains(empty) && !empty.overlaps(r));
+
+           auto unbounded =
+               spi.query<cppgres::range<int32_t>>("select '[5,)'::int4range").begin()[0];
+           result = result && _assert(!unbounded.upper.value.has_value());
+           result = result && _assert(unbounded.contains(1000000) && !unbounded.contains(4));
+
+           auto day = spi.query<cppgres::range<cppgres::timestamptz>>(
+                             "select tstzrange('2000-01-02', '2000-01-03')")
+                          .begin()[0];
+           result = result && _assert(day.contains(cppgres::timestamptz(24h + 1s)));
+           result = result && _assert(!day.contains(cppgres::timestamptz(48h)));
+
+           auto nums = spi.query<cppgres::range<cppgres::numeric>>("select numrange(1.5, 2.5)")
+                           .begin()[0];
+           result = result && _assert(nums.contains(cppgres::numeric::from_integer(2)));
+           result = result && _assert(!nums.contains(cppgres::numeric::from_integer(3)));
+
+           // Into datums
+           auto text =
+               spi.query<std::string>(
+                      "select $1::text || ' ' || $2::text",
+                      cppgres::range<int64_t>{.lower = {1, true}, .upper = {5, true}},
+                      cppgres::range<cppgres::date>{.lower = {cppgres::date(std::chrono::days(1))},
+                                                    .upper = {}})
+                   .begin()[0];
+           result = result && _assert(text == "[1,6) [2000-01-03,)");
+
+           {
+             cppgres::internal_subtransaction sub(false);
+             bool exception_raised = false;
+             try {
+               spi.query<std::string>("select $1::text",
+                                      cppgres::range<int64_t>{.lower = {5, true},
+                                                              .upper = {1, false}});
+             } catch (cppgres::pg_exception &) {
+               exception_raised = true;
+             }
+             result = result && _assert(exception_raised);
+           }
+
+           return result;
+         }));
+
+add_test(range_set, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function range_splits(int8) returns setof int8range language c as '{}'",
+               get_library_name()));
+           // Ranges are single values, not composites of their members
+           auto res = spi.query<cppgres::range<int64_t>>("select * from range_splits(3)");
+           result = result && _assert(res.count() == 3);
+           result = result && _assert(res.begin()[2].lower.value == 20);
+           result = result && _assert(res.begin()[2].upper.value == 30);
+           return result;
+         }));
+
+add_test(range_operators, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format(
+               "create function range_overlaps_cpp(int8range, int8range) returns bool "
+               "language c as '{}'",
+               get_library_name()));
+           spi.execute(cppgres::fmt::format(
+               "create function range_contains_cpp(int8range, int8range) returns bool "
+               "language c as '{}'",
+               get_library_name()));
+           // Same results as `&&` and `@>`
+           auto same = spi.query<bool>(
+               "with r(r) as (select int8range(i, j, b) from generate_series(0, 4) i, "
+               "generate_series(0, 4) j, unnest(array['[]', '()']) b where i <= j "
+               "union all values ('(,2)'::int8range), ('[3,)'), ('(,)'), ('empty')) "
+               "select bool_and(range_overlaps_cpp(a.r, b.r) = (a.r && b.r) and "
+               "range_contains_cpp(a.r, b.r) = (a.r @> b.r)) from r a, r b");
+           result = result && _assert(same.begin()[0]);
+
+           // A range type ordering its subtype in reverse
+           spi.execute("create function int8_desc_cmp(int8, int8) returns int immutable "
+                       "language sql as 'select btint8cmp($2, $1)'");
+           spi.execute("create operator class int8_desc_ops for type int8 using btree as "
+                       "operator 1 >, operator 2 >=, operator 3 =, operator 4 <=, operator 5 <, "
+                       "function 1 int8_desc_cmp(int8, int8)");
+           spi.execute("create type int8range_desc as range (subtype = int8, "
+                       "subtype_opclass = int8_desc_ops)");
+           spi.execute(cppgres::fmt::format(
+               "create function range_contains_value_cpp(int8range_desc, int8) returns bool "
+               "language c as '{}'",
+               get_library_name()));
+           auto same_desc = spi.query<bool>(
+               "select bool_and(range_contains_value_cpp(r, v) = (r @> v)) from "
+               "(values ('[10,1]'::int8range_desc), ('(5,2)'), ('[3,)')) r(r), "
+               "generate_series(0, 12) v");
+           result = result && _assert(same_desc.begin()[0]);
+           return result;
+         }));
+
+#if PG_MAJORVERSION_NUM >= 14
+add_test(multirange_conversions, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           auto m = spi.query<cppgres::multirange<int64_t>>(
+                           "select '{[1,3), [5,8), [10,12)}'::int8multirange")
+                        .begin()[0];
+           result = result && _assert(m.size() == 3);
+           result = result && _assert(m[1].lower.value == 5 && m[1].upper.value == 8);
+           result = result && _assert(m.contains(1) && m.contains(7) && m.contains(11));
+           result = result && _assert(!m.contains(3) && !m.contains(9) && !m.contains(12));
+           result = result &&
+                    _assert(m.overlaps(cppgres::range<int64_t>{.lower = {2, true},
+                                                               .upper = {4, false}}));
+           result = result &&
+                    _assert(!m.overlaps(cppgres::range<int64_t>{.lower = {3, true},
+                                                                .upper = {5, false}}));
+           result = result && _assert(m.overlaps(cppgres::range<int64_t>{.upper = {2, false}}));
+
+           std::vector<cppgres::range<int64_t>> ranges = {
+               {.lower = {4, true}, .upper = {6, false}},
+               {.lower = {1, true}, .upper = {3, false}},
+               {.lower = {2, true}, .upper = {4, false}}};
+           auto text = spi.query<std::string>("select $1::text",
+                                              cppgres::multirange<int64_t>(ranges))
+                           .begin()[0];
+           result = result && _assert(text == "{[1,6)}");
+
+           auto empty =
+               spi.query<cppgres::multirange<int64_t>>("select '{}'::int8multirange").begin()[0];
+           result = result && _assert(empty.empty() && !empty.contains(1));
+
+           return result;
+         }));
+#endif
+
+} // namespace tests
@@ -110,6 +110,95 @@ add_test(spi_result_iterator_sparse_cache, ([](test_case &) {
            return result;
          }));
 
+add_test(spi_result_iterator_shared_cache, ([](test_case &) {
+           bool result = true;
+           spi_counted_int::conversions = 0;
+
+           cppgres::spi_executor spi;
+           auto res = spi.query<spi_counted_int>("select i::int4 from generate_series(1,3) i");
+
+           // Iterators share decoded rows
+           auto it = res.begin() + 1;
+           result = result && _assert((*it).value == 2);
+           result = result && _assert(spi_counted_int::conversions == 1);
+           result = result && _assert(res.begin()[1].value == 2);
+           result = result && _assert((it - 1)[1].value == 2);
+           result = result && _assert(spi_counted_int::conversions == 1);
+           result = result && _assert(it[1].value == 3);
+           result = result && _assert(it - res.begin() == 1);
+
+           return result;
+         }));
+
+add_test(spi_result_multiple_columns, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           auto res = spi.query<std::tuple<int32_t, std::optional<int32_t>, std::string>>(
+               "select i, case when i % 2 = 0 then null else i end, i::text "
+               "from generate_series(1,10) i");
+           int32_t n = 0;
+           for (auto &[a, b, c] : res) {
+             n++;
+             result = result && _assert(a == n);
+             result = result && _assert(b.has_value() == (n % 2 != 0));
+             result = result && _assert(c == std::to_string(n));
+           }
+           result = result && _assert(n == 10);
+
+           auto vec = spi.query<std::vector<int32_t>>("select 1, 2, 3");
+           result = result && _assert(vec.begin()[0] == std::vector<int32_t>({1, 2, 3}));
+           return result;
+         }));
+
+add_test(spi_result_columns, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           auto res = spi.query<std::tuple<double, std::optional<int64_t>, std::string>>(
+               "select i::float8 / 2, case when i % 2 = 0 then null else i end, i::text "
+               "from generate_series(1,100) i");
+
+           auto doubles = res.column<double>(0);
+           result = result && _assert(doubles.size() == 100);
+           double sum = 0;
+           for (double v : doubles.values()) {
+             sum += v;
+           }
+           result = result && _assert(sum == 2525);
+
+           auto ints = res.column<int64_t>(1);
+           result = result && _assert(ints.is_null(1)) && _assert(!ints.is_null(0));
+           result = result && _assert(ints[2] == 3);
+           result = result && _assert(std::ranges::count(ints.nulls(), true) == 50);
+
+           auto texts = res.column<std::string>(2);
+           result = result && _assert(texts[9] == "10");
+           int n = 0;
+           for (auto v : texts.values()) {
+             n++;
+             result = result && _assert(v == std::to_string(n));
+           }
+           result = result && _assert(n == 100);
+
+           bool exception_raised = false;
+           try {
+             res.column<bool>(0);
+           } catch (std::invalid_argument &e) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           auto bool_res = spi.query<std::optional<bool>>(
+               "select case when i = 5 then null else i % 3 = 0 end from generate_series(1,6) i");
+           auto bools = bool_res.column<bool>(0);
+           std::span<const bool> bool_values = bools.values();
+           result = result && _assert(bool_values.size() == 6);
+           result = result && _assert(std::ranges::count(bool_values, true) == 2);
+           result = result && _assert(bools[2] && !bools[3]);
+           result = result && _assert(bools.is_null(4) && !bools.is_null(5));
+
+           return result;
+         }));
+
 add_test(spi_result_iterator_random_access_operations, ([](test_case &) {
            bool result = true;
            cppgres::spi_executor spi;
@@ -690,4 +779,195 @@ add_test(spi_query_dml, ([](test_case &) {
            return result;
          }));
 
+add_test(spi_cursor, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           {
+             auto c = spi.open_cursor<std::tuple<int64_t>>(
+                 "select i from generate_series(1,1000) i",
+                 cppgres::spi_executor::cursor_options(100));
+             int64_t sum = 0;
+             int n = 0;
+             for (auto &row : c) {
+               sum += std::get<0>(row);
+               n++;
+             }
+             result = result && _assert(n == 1000) && _assert(sum == 500500);
+           }
+
+           {
+             // batch size that doesn't divide the number of rows
+             auto plan = spi.plan<int64_t>("select i from generate_series(1,$1) i");
+             auto c = spi.open_cursor<std::tuple<int64_t>>(
+                 plan, cppgres::spi_executor::cursor_options(7), static_cast<int64_t>(100));
+             int n = 0;
+             for (auto &row : c) {
+               n++;
+               result = result && _assert(std::get<0>(row) == n);
+             }
+             result = result && _assert(n == 100);
+           }
+
+           {
+             // empty
+             auto c = spi.open_cursor<std::tuple<int64_t>>("select 1 where false");
+             result = result && _assert(c.begin() == c.end());
+           }
+
+           {
+             // cursor is closed when dropped
+             std::string name;
+             {
+               auto c = spi.open_cursor<std::tuple<int64_t>>("select 1");
+               name = c.name();
+             }
+             result = result && _assert(::SPI_cursor_find(name.c_str()) == nullptr);
+           }
+
+           return result;
+         }));
+
+postgres_function(spi_cursor_stream, ([](int64_t n) {
+                    return cppgres::spi_executor::stream<std::tuple<int64_t>>(
+                        "select i from generate_series(1,$1) i",
+                        cppgres::spi_executor::cursor_options(10), n);
+                  }));
+
+add_test(spi_cursor_stream, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format("create or replace function spi_cursor_stream(bigint) "
+                                            "returns setof bigint language c as '{}'",
+                                            get_library_name()));
+           auto res = spi.query<std::tuple<int64_t>>(
+               "select sum(i)::bigint from spi_cursor_stream(1000) i");
+           result = result && _assert(std::get<0>(res.begin()[0]) == 500500);
+           return result;
+         }));
+
+add_test(spi_statement_cache, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           using options = cppgres::spi_executor::options;
+           auto &cache = cppgres::spi_executor::statement_cache();
+           cache.clear();
+           auto hits = cache.hits();
+           auto misses = cache.misses();
+
+           for (int64_t i = 0; i < 10; i++) {
+             auto res = spi.query<int64_t>("select $1 + 1", options().cached(), i);
+             result = result && _assert(res.begin()[0] == i + 1);
+           }
+           result = result && _assert(cache.misses() == misses + 1);
+           result = result && _assert(cache.hits() == hits + 9);
+
+           // argument types and plan choice are a part of the key
+           spi.execute("select $1 + 1", options().cached(), static_cast<int32_t>(1));
+           spi.execute("select $1 + 1",
+                       options().cached(cppgres::spi_statement_cache::plan_choice::generic),
+                       static_cast<int32_t>(1));
+           result = result && _assert(cache.misses() == misses + 3);
+           result = result && _assert(cache.size() == 3);
+
+           // cached statements follow schema changes
+           spi.execute("create table spi_statement_cache_t (i int)");
+           spi.execute("insert into spi_statement_cache_t values (1)");
+           using row = std::vector<std::optional<int32_t>>;
+           auto q = "select * from spi_statement_cache_t";
+           result = result &&
+                    _assert(spi.query<row>(q, options().cached()).begin()[0].size() == 1);
+           spi.execute("alter table spi_statement_cache_t add column j int");
+           result = result &&
+                    _assert(spi.query<row>(q, options().cached()).begin()[0].size() == 2);
+
+           // least recently used statements are evicted
+           auto capacity = cache.capacity();
+           cache.set_capacity(1);
+           result = result && _assert(cache.size() == 1);
+           spi.execute("select 1", options().cached());
+           spi.execute("select 2", options().cached());
+           result = result && _assert(cache.size() == 1);
+           cache.set_capacity(capacity);
+           cache.clear();
+           result = result && _assert(cache.size() == 0);
+
+           return result;
+         }));
+
+add_test(spi_plan_batch, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute("create table spi_plan_batch (i int8, t text)");
+
+           auto insert =
+               spi.plan<int64_t, std::optional<std::string>>("insert into spi_plan_batch "
+                                                             "values ($1, $2)");
+           std::vector<std::tuple<int64_t, std::optional<std::string>>> rows;
+           for (int64_t i = 1; i <= 100; i++) {
+             rows.emplace_back(i, i % 10 == 0 ? std::nullopt
+                                              : std::optional<std::string>(std::to_string(i)));
+           }
+           result = result && _assert(spi.execute_batch(insert, rows) == 100);
+
+           auto lookup = spi.plan<int64_t>("select t from spi_plan_batch where i = $1");
+           std::vector<int64_t> keys = {1, 10, 55, 1000};
+           auto found = spi.query_batch<std::optional<std::string>>(lookup, keys);
+           result = result && _assert(found.size() == 3);
+           result = result && _assert(found[0] == "1");
+           result = result && _assert(!found[1].has_value());
+           result = result && _assert(found[2] == "55");
+
+           return result;
+         }));
+
+#if PG_MAJORVERSION_NUM >= 14
+add_test(spi_for_each, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           int64_t sum = 0;
+           auto n = spi.for_each<std::tuple<int64_t, std::string>>(
+               "select i, i::text from generate_series(1,$1) i",
+               [&](auto &row) {
+                 sum += std::get<0>(row);
+                 result = result && _assert(std::get<1>(row) == std::to_string(std::get<0>(row)));
+               },
+               static_cast<int64_t>(1000));
+           result = result && _assert(n == 1000) && _assert(sum == 500500);
+
+           // cached statements take arguments too
+           int64_t cached_sum = 0;
+           for (int i = 0; i < 2; i++) {
+             spi.for_each<int64_t>(
+                 "select i from generate_series(1,$1) i",
+                 cppgres::spi_executor::options().cached(),
+                 [&](int64_t &i) { cached_sum += i; }, static_cast<int64_t>(10));
+           }
+           result = result && _assert(cached_sum == 110);
+
+           // output iterator
+           std::vector<int32_t> values;
+           auto plan = spi.plan<int32_t>("select i from generate_series(1,$1) i");
+           spi.for_each<int32_t>(plan, std::back_inserter(values), static_cast<int32_t>(5));
+           result = result && _assert(values == std::vector<int32_t>({1, 2, 3, 4, 5}));
+
+           // exceptions thrown by the sink are propagated
+           bool exception_raised = false;
+           cppgres::internal_subtransaction sub(false);
+           try {
+             spi.for_each<int64_t>("select i from generate_series(1,10) i", [](int64_t &i) {
+               if (i == 5) {
+                 throw std::logic_error("stop");
+               }
+             });
+           } catch (std::logic_error &e) {
+             exception_raised = std::string_view(e.what()) == "stop";
+           }
+           result = result && _assert(exception_raised);
+
+           return result;
+         }));
+#endif
+
 } // namespace tests
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <ranges>
 #include <tuple>
 
@@ -10,14 +11,38 @@ struct srf_pfr_res {
   int32_t a, b;
 };
 
+struct srf_counted_text {
+  std::string value;
+  static inline int conversions = 0;
+};
+
 namespace cppgres {
 template <> struct type_traits<srf_pfr_res> {
   bool is(const type &t) { return t.oid == RECORDOID; }
   constexpr type type_for() { return type{.oid = RECORDOID}; }
 };
 
+template <>
+struct datum_conversion<srf_counted_text> : default_datum_conversion<srf_counted_text> {
+  static datum into_datum(const srf_counted_text &t) {
+    srf_counted_text::conversions++;
+    return datum_conversion<std::string>::into_datum(t.value);
+  }
+};
+
+template <> struct type_traits<srf_counted_text> {
+  bool is(const type &t) { return type_traits<std::string>().is(t); }
+  type type_for() { return type_traits<std::string>().type_for(); }
+};
+
 } // namespace cppgres
 
+struct srf_value_per_call_token {
+  static inline int produced = 0;
+  static inline int destroyed = 0;
+  ~srf_value_per_call_token() { destroyed++; }
+};
+
 namespace tests {
 
 postgres_function(srf, ([]() {
@@ -167,4 +192,95 @@ add_test(srf_non_record_non_tup_type_mismatch, ([](test_case &) {
            return result;
          }));
 
+postgres_function(srf_value_per_call, ([](int32_t n) {
+                    auto token = std::make_shared<srf_value_per_call_token>();
+                    return cppgres::value_per_call(
+                        std::views::iota(0, n) | std::views::transform([token](int32_t i) {
+                          srf_value_per_call_token::produced++;
+                          return i;
+                        }));
+                  }));
+
+add_test(srf_value_per_call, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           auto stmt = cppgres::fmt::format("create or replace function srf_value_per_call(int) "
+                                            "returns setof int language 'c' as '{}'",
+                                            get_library_name());
+           spi.execute(stmt);
+
+           {
+             // Stopped early: only the rows read are produced, and the range is torn down
+             srf_value_per_call_token::produced = 0;
+             srf_value_per_call_token::destroyed = 0;
+             auto res = spi.query<int32_t>("select srf_value_per_call(1000000) limit 3");
+             result = result && _assert(res.count() == 3);
+             result = result && _assert(res.begin()[2] == 2);
+             result = result && _assert(srf_value_per_call_token::produced <= 4);
+             result = result && _assert(srf_value_per_call_token::destroyed == 1);
+           }
+
+           {
+             // Read to the end
+             srf_value_per_call_token::destroyed = 0;
+             auto res = spi.query<int64_t>("select sum(i) from srf_value_per_call(100) i");
+             result = result && _assert(res.begin()[0] == 4950);
+             result = result && _assert(srf_value_per_call_token::destroyed == 1);
+           }
+
+           return result;
+         }));
+
+postgres_function(srf_value_per_call_text, ([](std::string_view s) {
+                    return cppgres::value_per_call(
+                        std::views::iota(0, 3) | std::views::transform([s](int32_t i) {
+                          return static_cast<int32_t>(std::ranges::count(s, 'x')) + i;
+                        }));
+                  }));
+
+add_test(srf_value_per_call_toasted_argument, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           spi.execute(cppgres::fmt::format("create or replace function srf_value_per_call_text("
+                                            "text) returns setof int language 'c' as '{}'",
+                                            get_library_name()));
+           spi.execute("create table srf_toasted (t text)");
+           spi.execute("alter table srf_toasted alter column t set storage external");
+           spi.execute("insert into srf_toasted values (repeat('x', 1000000))");
+
+           // The argument is detoasted when converted, and read again for every row, after the
+           // per-tuple memory of the first call was reset
+           auto res = spi.query<int32_t>("select srf_value_per_call_text(t) from srf_toasted");
+           result = result && _assert(res.count() == 3);
+           result = result && _assert(res.begin()[0] == 1000000 && res.begin()[2] == 1000002);
+           return result;
+         }));
+
+postgres_function(srf_single_pass, ([](int32_t n) {
+                    return std::views::iota(0, n) | std::views::transform([](int32_t i) {
+                             return std::tuple<srf_counted_text, std::optional<int32_t>>(
+                                 srf_counted_text{std::string(100, 'x')},
+                                 i % 2 == 0 ? std::optional<int32_t>(i) : std::nullopt);
+                           });
+                  }));
+
+add_test(srf_single_pass, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+           auto stmt = cppgres::fmt::format("create or replace function srf_single_pass(int) "
+                                            "returns table (t text, i int) language 'c' as '{}'",
+                                            get_library_name());
+           spi.execute(stmt);
+
+           srf_counted_text::conversions = 0;
+           auto res = spi.query<std::tuple<std::string, std::optional<int32_t>>>(
+               "select * from srf_single_pass(1000)");
+           result = result && _assert(res.count() == 1000);
+           // every value is converted once
+           result = result && _assert(srf_counted_text::conversions == 1000);
+           result = result && _assert(std::get<1>(res.begin()[2]) == 2);
+           result = result && _assert(!std::get<1>(res.begin()[3]).has_value());
+           return result;
+         }));
+
 } // namespace tests
@@ -24,14 +24,21 @@ PG_MODULE_MAGIC;
 #include "tests.hpp"
 
 #include "aggregate.hpp"
+#include "array.hpp"
 #include "backend.hpp"
 #include "bgw.hpp"
+#include "datetime.hpp"
 #include "datum.hpp"
 #include "errors.hpp"
+#include "expression.hpp"
 #include "function.hpp"
 #include "heap_tuple.hpp"
+#include "inet.hpp"
+#include "jsonb.hpp"
 #include "memory_context.hpp"
 #include "node.hpp"
+#include "numeric.hpp"
+#include "range.hpp"
 #include "record.hpp"
 #include "role.hpp"
 #include "spi.hpp"
@@ -40,6 +47,7 @@ PG_MODULE_MAGIC;
 #include "threading.hpp"
 #include "type.hpp"
 #include "typeconv.hpp"
+#include "uuid.hpp"
 #include "xact.hpp"
 
 test_case::test_case(std::string_view name, bool (*function)(test_case &c), bool is_atomic)
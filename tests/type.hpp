@@ -11,6 +11,12 @@ struct my_custom_type {
   static cppgres::type composite_type() { return cppgres::named_type("custom_type"); }
 };
 
+struct my_cached_type {
+  std::string s;
+  int32_t i;
+  static cppgres::type composite_type() { return cppgres::named_type("cached_custom_type"); }
+};
+
 namespace tests {
 
 add_test(type_name_smoke, [](test_case &) {
@@ -98,6 +104,32 @@ add_test(
       return result;
     }));
 
+add_test(composite_type_descriptor_invalidation, ([](test_case &) {
+           bool result = true;
+
+           cppgres::spi_executor spi;
+           spi.execute("create type cached_custom_type as (s text, i int)");
+
+           for (int32_t i = 0; i < 100; i++) {
+             auto d = cppgres::datum_conversion<my_cached_type>::into_datum({.s = "test", .i = i});
+             auto v = cppgres::datum_conversion<my_cached_type>::from_datum(
+                 d, my_cached_type::composite_type().oid, std::nullopt);
+             result = result && _assert(v.s == "test") && _assert(v.i == i);
+           }
+
+           // Descriptor is re-checked once the type changes
+           spi.execute("alter type cached_custom_type alter attribute i type bigint");
+           bool exception_raised = false;
+           try {
+             cppgres::datum_conversion<my_cached_type>::into_datum({.s = "test", .i = 1});
+           } catch (std::invalid_argument &e) {
+             exception_raised = true;
+           }
+           result = result && _assert(exception_raised);
+
+           return result;
+         }));
+
 add_test(tuples_are_records, ([](test_case &) {
            bool result = true;
 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include "tests.hpp"
+
+namespace tests {
+
+postgres_function(uuid_version, ([](cppgres::uuid id) {
+                    return static_cast<int32_t>(std::to_integer<uint8_t>(id.bytes()[6]) >> 4);
+                  }));
+
+add_test(uuid_conversions, ([](test_case &) {
+           bool result = true;
+           cppgres::spi_executor spi;
+
+           auto id = spi.query<cppgres::uuid>(
+                            "select '00112233-4455-6677-8899-aabbccddeeff'::uuid")
+                         .begin()[0];
+           result = result && _assert(id.bytes()[0] == std::byte{0x00});
+           result = result && _assert(id.bytes()[5] == std::byte{0x55});
+           result = result && _assert(id.bytes()[15] == std::byte{0xff});
+
+           auto bytes = id.to_array();
+           bytes[15] = std::byte{0x00};
+           auto text =
+               spi.query<std::string>("select $1::text", cppgres::uuid(bytes)).begin()[0];
+           result = result && _assert(text == "00112233-4455-6677-8899-aabbccddee00");
+
+           // Ordered the same way as in Postgres
+           result = result && _assert(cppgres::uuid(bytes) < id);
+           result = result && _assert(cppgres::uuid(id.to_array()) == id);
+
+           spi.execute(cppgres::fmt::format(
+               "create function uuid_version(uuid) returns int4 language c as '{}'",
+               get_library_name()));
+           auto versions = spi.query<bool>(
+               "select bool_and(uuid_version(gen_random_uuid()) = 4) from generate_series(1, 100)");
+           result = result && _assert(versions.begin()[0]);
+
+           return result;
+         }));
+
+} // namespace tests